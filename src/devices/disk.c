@@ -60,6 +60,8 @@ struct disk
 
     long long read_cnt;         /* Number of sectors read. */
     long long write_cnt;        /* Number of sectors written. */
+    long long read_req_cnt;     /* Number of read commands issued. */
+    long long write_req_cnt;    /* Number of write commands issued. */
   };
 
 /* An ATA channel (aka controller).
@@ -86,7 +88,7 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void select_sector (struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -124,7 +126,7 @@ disk_init (void)
         default:
           NOT_REACHED ();
         }
-      lock_init (&c->lock);
+      lock_init_named (&c->lock, c->name);
       c->expecting_interrupt = false;
       sema_init (&c->completion_wait, 0);
  
@@ -173,8 +175,10 @@ disk_print_stats (void)
         {
           struct disk *d = disk_get (chan_no, dev_no);
           if (d != NULL && d->is_ata) 
-            printf ("%s: %lld reads, %lld writes\n",
-                    d->name, d->read_cnt, d->write_cnt);
+            printf ("%s: %lld reads in %lld requests, "
+                    "%lld writes in %lld requests\n",
+                    d->name, d->read_cnt, d->read_req_cnt,
+                    d->write_cnt, d->write_req_cnt);
         }
     }
 }
@@ -218,46 +222,91 @@ disk_size (struct disk *d)
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) 
+{
+  disk_read_multiple (d, sec_no, &buffer, 1);
+}
+
+/* Write sector SEC_NO to disk D from BUFFER, which must contain
+   DISK_SECTOR_SIZE bytes.  Returns after the disk has
+   acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer)
+{
+  disk_write_multiple (d, sec_no, &buffer, 1);
+}
+
+/* Reads the CNT sectors starting at SEC_NO from disk D with a
+   single command, sector I into BUFFERS[I], which must have room
+   for DISK_SECTOR_SIZE bytes.  CNT may be at most
+   DISK_MAX_SECTORS.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no,
+                    void *const buffers[], size_t cnt) 
 {
   struct channel *c;
+  size_t i;
   
   ASSERT (d != NULL);
-  ASSERT (buffer != NULL);
+  ASSERT (buffers != NULL);
+  ASSERT (cnt > 0 && cnt <= DISK_MAX_SECTORS);
 
   c = d->channel;
   lock_acquire (&c->lock);
-  select_sector (d, sec_no);
+  select_sector (d, sec_no, cnt);
   issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-  sema_down (&c->completion_wait);
-  if (!wait_while_busy (d))
-    PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-  input_sector (c, buffer);
-  d->read_cnt++;
+  for (i = 0; i < cnt; i++) 
+    {
+      /* The disk interrupts once per sector, when it is ready. */
+      sema_down (&c->completion_wait);
+      if (!wait_while_busy (d))
+        PANIC ("%s: disk read failed, sector=%"PRDSNu,
+               d->name, sec_no + i);
+      input_sector (c, buffers[i]);
+    }
+  d->read_cnt += cnt;
+  d->read_req_cnt++;
   lock_release (&c->lock);
 }
 
-/* Write sector SEC_NO to disk D from BUFFER, which must contain
-   DISK_SECTOR_SIZE bytes.  Returns after the disk has
-   acknowledged receiving the data.
+/* Writes the CNT sectors starting at SEC_NO to disk D with a
+   single command, sector I from BUFFERS[I], which must contain
+   DISK_SECTOR_SIZE bytes.  CNT may be at most DISK_MAX_SECTORS.
+   Returns after the disk has acknowledged receiving the data.
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void
-disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer)
+disk_write_multiple (struct disk *d, disk_sector_t sec_no,
+                     const void *const buffers[], size_t cnt)
 {
   struct channel *c;
+  size_t i;
   
   ASSERT (d != NULL);
-  ASSERT (buffer != NULL);
+  ASSERT (buffers != NULL);
+  ASSERT (cnt > 0 && cnt <= DISK_MAX_SECTORS);
 
   c = d->channel;
   lock_acquire (&c->lock);
-  select_sector (d, sec_no);
+  select_sector (d, sec_no, cnt);
   issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-  if (!wait_while_busy (d))
-    PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-  output_sector (c, buffer);
+  for (i = 0; i < cnt; i++) 
+    {
+      /* The disk interrupts after each sector but the last when
+         it is ready for the next one. */
+      if (i > 0)
+        sema_down (&c->completion_wait);
+      if (!wait_while_busy (d))
+        PANIC ("%s: disk write failed, sector=%"PRDSNu,
+               d->name, sec_no + i);
+      output_sector (c, buffers[i]);
+    }
   sema_down (&c->completion_wait);
-  d->write_cnt++;
+  d->write_cnt += cnt;
+  d->write_req_cnt++;
   lock_release (&c->lock);
 }
 
@@ -426,18 +475,18 @@ print_ata_string (char *string, size_t size)
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and the number of sectors CNT to the disk's
+   sector selection registers.  (We use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) 
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) 
 {
   struct channel *c = d->channel;
 
-  ASSERT (sec_no < d->capacity);
-  ASSERT (sec_no < (1UL << 28));
+  ASSERT (sec_no + cnt <= d->capacity);
+  ASSERT (sec_no + cnt <= (1UL << 28));
   
   select_device_wait (d);
-  outb (reg_nsect (c), 1);
+  outb (reg_nsect (c), cnt == DISK_MAX_SECTORS ? 0 : cnt);
   outb (reg_lbal (c), sec_no);
   outb (reg_lbam (c), sec_no >> 8);
   outb (reg_lbah (c), (sec_no >> 16));
@@ -17,9 +17,64 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency divided by TIMER_FREQ, rounded to
+   nearest: the PIT count for one timer tick. */
+#define PIT_TICK_COUNT ((1193180 + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Most ticks a single one-shot PIT count can span. */
+#define TICKLESS_MAX (0xffff / PIT_TICK_COUNT)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* Hierarchical timing wheel holding every pending struct timer.
+
+   There are WHEEL_LEVELS levels of WHEEL_SLOTS slots each.  A
+   timer less than WHEEL_SLOTS**(L + 1) ticks away goes on level
+   L, in the slot selected by bits L * WHEEL_BITS and up of its
+   deadline.  Each tick expires the current level 0 slot, and
+   whenever a level's slot index wraps back to 0 the current slot
+   of the next level up is "cascaded", that is, its timers are
+   reinserted, which moves them to a lower level.  Adding and
+   cancelling a timer are O(1), and a tick only touches timers
+   that are due or are being cascaded.  Timers farther away than
+   the whole wheel are parked in the last slot of the top level
+   and cascaded around again. */
+#define WHEEL_BITS 6                            /* Slot index bits. */
+#define WHEEL_SLOTS (1 << WHEEL_BITS)           /* Slots per level. */
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4                          /* Levels. */
+#define WHEEL_SPAN(LEVEL) ((int64_t) 1 << (WHEEL_BITS * (LEVEL)))
+
+static struct list wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+static int64_t wheel_ticks;     /* Last tick the wheel processed. */
+
+/* Tickless idle.  While idle, timer_idle_enter() may program the
+   PIT to interrupt once after tickless_ticks ticks instead of
+   every tick; the timer interrupt then accounts for all of them
+   at once, unless another interrupt comes first and
+   timer_catch_up() does. */
+bool timer_tickless;
+static bool tickless_pending;   /* One-shot count in progress? */
+static unsigned tickless_ticks; /* Ticks it spans. */
+static unsigned tickless_count; /* PIT count it was loaded with. */
+static int64_t ticks_avoided;   /* Timer interrupts not taken. */
+
+static void pit_periodic (void);
+static void pit_one_shot (unsigned count);
+static unsigned pit_read (void);
+static int64_t wheel_next_event (int64_t limit);
+static void wheel_insert (struct timer *);
+static void wheel_cascade (int level);
+static void wheel_advance (void);
+static void wheel_run (void *aux);
+static void sleep_expire (void *t_);
+
+/* Deferred work that runs wheel_run() after the timer interrupt,
+   so that timer functions do not add to the time the interrupt
+   handler keeps interrupts off. */
+static struct intr_work wheel_work;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
@@ -36,13 +91,14 @@ static void real_time_delay (int64_t num, int32_t denom);
 void
 timer_init (void) 
 {
-  /* 8254 input frequency divided by TIMER_FREQ, rounded to
-     nearest. */
-  uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+  int level, slot;
 
-  outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-  outb (0x40, count & 0xff);
-  outb (0x40, count >> 8);
+  pit_periodic ();
+
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    for (slot = 0; slot < WHEEL_SLOTS; slot++)
+      list_init (&wheel[level][slot]);
+  intr_work_init (&wheel_work, wheel_run, NULL);
 
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
@@ -99,27 +155,76 @@ void
 timer_sleep (int64_t ticks) 
 {
   int64_t start = timer_ticks ();
-  int64_t wakeup_at = start + ticks;
   
   ASSERT (intr_get_level () == INTR_ON);
-  /* 
-     while (timer_elapsed (start) < ticks) 
-     thread_yield (); 
-  */
 
   if(ticks > 0)
   {
-    /* Put the thread to sleep in timer sleep queue. */
-   // thread_priority_temporarily_up ();
-    thread_block_till (wakeup_at);
-
-    /* Thread must quit sleep and also free its successor
-       if that thread needs to wakeup at the same time. */
-   // thread_set_next_wakeup ();
-   // thread_priority_restore ();
+    /* Block until a timer on our own stack unblocks us. */
+    struct timer t;
+    enum intr_level old_level = intr_disable ();
+    timer_add (&t, start + ticks, sleep_expire, thread_current ());
+    thread_block ();
+    intr_set_level (old_level);
   }
 }
 
+/* Timer function for timer_sleep(): wakes up sleeping thread T_,
+   preempting the interrupted thread if T_ should run first. */
+static void
+sleep_expire (void *t_)
+{
+  struct thread *t = t_;
+
+  thread_unblock (t);
+  if (thread_should_preempt (t))
+    intr_yield_on_return ();
+}
+
+/* Arranges for FUNC to be called with AUX, in interrupt context
+   and with interrupts off, once timer_ticks() reaches DEADLINE.  A deadline
+   that has already passed expires on the next tick.  T must not
+   already be pending.  May be called from an interrupt handler,
+   including from a timer function. */
+void
+timer_add (struct timer *t, int64_t deadline, timer_func *func, void *aux)
+{
+  enum intr_level old_level;
+
+  ASSERT (t != NULL);
+  ASSERT (func != NULL);
+
+  old_level = intr_disable ();
+  t->deadline = deadline > wheel_ticks ? deadline : wheel_ticks + 1;
+  t->func = func;
+  t->aux = aux;
+  t->pending = true;
+  wheel_insert (t);
+  intr_set_level (old_level);
+}
+
+/* Cancels timer T.  Returns true if T was pending, false if it
+   had already expired or been cancelled. */
+bool
+timer_cancel (struct timer *t)
+{
+  enum intr_level old_level;
+  bool was_pending;
+
+  ASSERT (t != NULL);
+
+  old_level = intr_disable ();
+  was_pending = t->pending;
+  if (was_pending)
+    {
+      list_remove (&t->elem);
+      t->pending = false;
+    }
+  intr_set_level (old_level);
+
+  return was_pending;
+}
+
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
    turned on. */
 void
@@ -188,14 +293,251 @@ void
 timer_print_stats (void) 
 {
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+  if (timer_tickless)
+    printf ("Timer: %"PRId64" interrupts avoided by tickless idle\n",
+            ticks_avoided);
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  In tickless mode, if no timer is due for a while,
+   reprograms the PIT to interrupt only when the next one is. */
+void
+timer_idle_enter (void)
+{
+  int64_t next;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_tickless || tickless_pending)
+    return;
+
+  next = wheel_next_event (ticks + TICKLESS_MAX);
+  if (next - ticks > 1)
+    {
+      tickless_ticks = next - ticks;
+      tickless_count = tickless_ticks * PIT_TICK_COUNT;
+      tickless_pending = true;
+      pit_one_shot (tickless_count);
+    }
+}
+
+/* Called by intr_handler() at the start of every external
+   interrupt other than the timer's.  If the interrupt came before
+   a one-shot count ran out, it may wake a thread, which is then
+   switched to on return from the interrupt, before the idle
+   thread runs again, and which expects timer_ticks() to be
+   accurate.  So the count is cut short right here: the whole
+   ticks that have passed are accounted for at once, to the idle
+   thread that is still current, and the PIT is reloaded to
+   interrupt at the end of the current tick. */
+void
+timer_catch_up (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (intr_context ());
+
+  if (tickless_pending)
+    {
+      unsigned remaining = pit_read ();
+
+      /* Otherwise the count just ran out and the interrupt is on
+         its way. */
+      if (remaining > 0 && remaining <= tickless_count)
+        {
+          unsigned elapsed = tickless_count - remaining;
+          unsigned whole = elapsed / PIT_TICK_COUNT;
+          unsigned partial = PIT_TICK_COUNT - elapsed % PIT_TICK_COUNT;
+
+          ticks_avoided += whole;
+          while (whole-- > 0)
+            {
+              ticks++;
+              thread_tick ();
+            }
+          tickless_ticks = 1;
+          tickless_count = partial;
+          pit_one_shot (partial);
+        }
+    }
+}
+
+/* Returns the number of timer interrupts that tickless idle has
+   avoided so far. */
+int64_t
+timer_ticks_avoided (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  int64_t avoided = ticks_avoided;
+  intr_set_level (old_level);
+  return avoided;
 }
 
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
-  ticks++;
-  thread_tick ();
+  unsigned n = 1;
+
+  /* A one-shot count stands for several ticks at once. */
+  if (tickless_pending)
+    {
+      tickless_pending = false;
+      pit_periodic ();
+      n = tickless_ticks;
+      ticks_avoided += n - 1;
+    }
+
+  while (n-- > 0)
+    {
+      ticks++;
+      thread_tick ();
+    }
+  intr_defer (&wheel_work);
+}
+
+/* Sets up the 8254 Programmable Interval Timer (PIT) to
+   interrupt TIMER_FREQ times per second. */
+static void
+pit_periodic (void)
+{
+  outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+  outb (0x40, PIT_TICK_COUNT & 0xff);
+  outb (0x40, PIT_TICK_COUNT >> 8);
+}
+
+/* Sets up the PIT to interrupt once, COUNT input cycles from
+   now. */
+static void
+pit_one_shot (unsigned count)
+{
+  ASSERT (count > 0 && count <= 0xffff);
+
+  outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+  outb (0x40, count & 0xff);
+  outb (0x40, count >> 8);
+}
+
+/* Returns the PIT's current count. */
+static unsigned
+pit_read (void)
+{
+  unsigned lo, hi;
+
+  outb (0x43, 0x00);    /* CW: counter 0, latch count. */
+  lo = inb (0x40);
+  hi = inb (0x40);
+  return lo | (hi << 8);
+}
+
+/* Returns the first tick after the current one at which the wheel
+   has work to do, either a timer to expire or a cascade, or LIMIT
+   if that is sooner.  Interrupts must be off. */
+static int64_t
+wheel_next_event (int64_t limit)
+{
+  int64_t t;
+
+  for (t = wheel_ticks + 1; t < limit; t++)
+    if ((t & WHEEL_MASK) == 0
+        || !list_empty (&wheel[0][t & WHEEL_MASK]))
+      break;
+  return t;
+}
+
+/* Puts pending timer T in the wheel slot for its deadline,
+   relative to wheel_ticks.  A timer due at wheel_ticks itself,
+   which happens when a cascade moves a timer whose deadline is a
+   multiple of WHEEL_SLOTS down on the tick it is due, goes in
+   the current level 0 slot, which wheel_advance() expires right
+   after cascading.  Interrupts must be off. */
+static void
+wheel_insert (struct timer *t)
+{
+  int64_t when = t->deadline;
+  int64_t delta = when - wheel_ticks;
+  int level;
+
+  ASSERT (delta >= 0);
+
+  for (level = 0; level < WHEEL_LEVELS - 1; level++)
+    if (delta < WHEEL_SPAN (level + 1))
+      break;
+  if (delta >= WHEEL_SPAN (WHEEL_LEVELS))
+    when = wheel_ticks + WHEEL_SPAN (WHEEL_LEVELS) - 1;
+
+  list_push_back (&wheel[level][(when >> (WHEEL_BITS * level)) & WHEEL_MASK],
+                  &t->elem);
+}
+
+/* Reinserts every timer in the current slot of LEVEL, moving
+   each one to a lower level.  Interrupts must be off. */
+static void
+wheel_cascade (int level)
+{
+  struct list *slot = &wheel[level][(wheel_ticks >> (WHEEL_BITS * level))
+                                    & WHEEL_MASK];
+  struct list moving;
+
+  list_init (&moving);
+  if (!list_empty (slot))
+    list_splice (list_end (&moving), list_begin (slot), list_end (slot));
+  while (!list_empty (&moving))
+    wheel_insert (list_entry (list_pop_front (&moving), struct timer, elem));
+}
+
+/* Deferred work for the timer interrupt: brings the wheel up to
+   the current tick, one tick at a time. */
+static void
+wheel_run (void *aux UNUSED)
+{
+  enum intr_level old_level = intr_disable ();
+
+  while (wheel_ticks < ticks)
+    wheel_advance ();
+  intr_set_level (old_level);
+}
+
+/* Advances the wheel by one tick and calls the timer function of
+   every timer that is now due.  Interrupts must be off, but are
+   turned back on briefly between timer functions. */
+static void
+wheel_advance (void)
+{
+  struct list *slot;
+  struct list expired;
+  int level;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  wheel_ticks++;
+
+  /* Cascade from the highest level whose index just wrapped,
+     working down, so that timers falling all the way to level 0
+     land in this tick's slot before it is expired. */
+  for (level = 1; level < WHEEL_LEVELS; level++)
+    if (((wheel_ticks >> (WHEEL_BITS * level - WHEEL_BITS)) & WHEEL_MASK) != 0)
+      break;
+  while (--level >= 1)
+    wheel_cascade (level);
+
+  /* Detach this tick's slot first, so that a timer function that
+     adds a timer WHEEL_SLOTS ticks out does not see it expire. */
+  slot = &wheel[0][wheel_ticks & WHEEL_MASK];
+  list_init (&expired);
+  if (!list_empty (slot))
+    list_splice (list_end (&expired), list_begin (slot), list_end (slot));
+  while (!list_empty (&expired))
+    {
+      struct timer *t = list_entry (list_pop_front (&expired),
+                                    struct timer, elem);
+      ASSERT (t->deadline == wheel_ticks);
+      t->pending = false;
+      t->func (t->aux);
+
+      /* Let other interrupts in. */
+      intr_enable ();
+      intr_disable ();
+    }
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -1,14 +1,23 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* If true, the PIT is reprogrammed in one-shot mode while the CPU
+   is idle, skipping ticks in which no timer is due.
+   Controlled by kernel command-line option "-tickless". */
+extern bool timer_tickless;
+
 void timer_init (void);
 void timer_calibrate (void);
+void timer_idle_enter (void);
+void timer_catch_up (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
@@ -24,6 +33,27 @@ void timer_mdelay (int64_t milliseconds);
 void timer_udelay (int64_t microseconds);
 void timer_ndelay (int64_t nanoseconds);
 
+int64_t timer_ticks_avoided (void);
 void timer_print_stats (void);
 
+/* Function called when a timer expires, given auxiliary data
+   AUX.  It runs inside the timer interrupt handler, with
+   interrupts off, so it must not sleep.  It may call
+   intr_yield_on_return(). */
+typedef void timer_func (void *aux);
+
+/* A one-shot kernel timer.  The caller owns the storage, which
+   must stay valid until the timer fires or is cancelled. */
+struct timer
+  {
+    struct list_elem elem;      /* Element in a timing wheel slot. */
+    int64_t deadline;           /* Tick at which FUNC is called. */
+    timer_func *func;           /* Expiry function. */
+    void *aux;                  /* Auxiliary data for FUNC. */
+    bool pending;               /* Added and not yet expired or cancelled. */
+  };
+
+void timer_add (struct timer *, int64_t deadline, timer_func *, void *aux);
+bool timer_cancel (struct timer *);
+
 #endif /* devices/timer.h */
@@ -0,0 +1,234 @@
+/* Priority queue.
+
+   See pqueue.h for basic information.
+
+   A pairing heap is a heap-ordered tree of any shape, stored as
+   a leftmost-child, right-sibling binary tree.  Pushing melds a
+   new one-node tree with the root.  Popping the root leaves its
+   children as a list of trees, which are melded back into one in
+   two passes: first in pairs from left to right, then the pairs
+   from right to left.  The second pass is what makes the
+   amortized cost logarithmic. */
+
+#include "pqueue.h"
+#include "../debug.h"
+
+static bool before (const struct pqueue *,
+                    const struct pqueue_elem *, const struct pqueue_elem *);
+static struct pqueue_elem *meld (const struct pqueue *,
+                                 struct pqueue_elem *, struct pqueue_elem *);
+static struct pqueue_elem *merge_pairs (const struct pqueue *,
+                                        struct pqueue_elem *);
+static void detach (struct pqueue_elem *);
+static void insert (struct pqueue *, struct pqueue_elem *);
+static void extract (struct pqueue *, struct pqueue_elem *);
+
+/* Initializes PQ as an empty priority queue that compares
+   elements using LESS, given auxiliary data AUX. */
+void
+pqueue_init (struct pqueue *pq, pqueue_less_func *less, void *aux) 
+{
+  ASSERT (pq != NULL);
+  ASSERT (less != NULL);
+
+  pq->root = NULL;
+  pq->elem_cnt = 0;
+  pq->next_seq = 0;
+  pq->less = less;
+  pq->aux = aux;
+}
+
+/* Inserts ELEM into PQ. */
+void
+pqueue_push (struct pqueue *pq, struct pqueue_elem *elem) 
+{
+  ASSERT (pq != NULL);
+  ASSERT (elem != NULL);
+
+  elem->seq = pq->next_seq++;
+  insert (pq, elem);
+  pq->elem_cnt++;
+}
+
+/* Removes and returns the maximum element of PQ, which must not
+   be empty.  Of several maximum elements, the one pushed first
+   is returned. */
+struct pqueue_elem *
+pqueue_pop_max (struct pqueue *pq) 
+{
+  struct pqueue_elem *max = pqueue_max (pq);
+
+  pqueue_remove (pq, max);
+  return max;
+}
+
+/* Removes ELEM, which must be in PQ, from PQ. */
+void
+pqueue_remove (struct pqueue *pq, struct pqueue_elem *elem) 
+{
+  ASSERT (pq != NULL);
+  ASSERT (elem != NULL);
+  ASSERT (pq->elem_cnt > 0);
+
+  extract (pq, elem);
+  pq->elem_cnt--;
+}
+
+/* Moves ELEM, which must be in PQ, to its proper place after its
+   key changed.  ELEM keeps its place among elements that compare
+   equal to it. */
+void
+pqueue_update (struct pqueue *pq, struct pqueue_elem *elem) 
+{
+  ASSERT (pq != NULL);
+  ASSERT (elem != NULL);
+
+  extract (pq, elem);
+  insert (pq, elem);
+}
+
+/* Returns the maximum element of PQ, which must not be empty. */
+struct pqueue_elem *
+pqueue_max (struct pqueue *pq) 
+{
+  ASSERT (pq != NULL);
+  ASSERT (pq->root != NULL);
+
+  return pq->root;
+}
+
+/* Returns the number of elements in PQ. */
+size_t
+pqueue_size (struct pqueue *pq) 
+{
+  ASSERT (pq != NULL);
+  return pq->elem_cnt;
+}
+
+/* Returns true if PQ is empty, false otherwise. */
+bool
+pqueue_empty (struct pqueue *pq) 
+{
+  ASSERT (pq != NULL);
+  return pq->root == NULL;
+}
+
+/* Returns true if A belongs ahead of B in PQ: if it is greater,
+   or equal but pushed earlier.  Sequence numbers are compared by
+   difference so that they may wrap around. */
+static bool
+before (const struct pqueue *pq,
+        const struct pqueue_elem *a, const struct pqueue_elem *b) 
+{
+  if (pq->less (b, a, pq->aux))
+    return true;
+  else if (pq->less (a, b, pq->aux))
+    return false;
+  else
+    return (int) (a->seq - b->seq) < 0;
+}
+
+/* Melds heap-ordered trees A and B, either of which may be null,
+   and returns the root of the result.  Neither A nor B may have
+   siblings or a parent. */
+static struct pqueue_elem *
+meld (const struct pqueue *pq, struct pqueue_elem *a, struct pqueue_elem *b) 
+{
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+  if (before (pq, b, a)) 
+    {
+      struct pqueue_elem *t = a;
+      a = b;
+      b = t;
+    }
+
+  /* B becomes A's leftmost child. */
+  b->prev = a;
+  b->next = a->child;
+  if (a->child != NULL)
+    a->child->prev = b;
+  a->child = b;
+  return a;
+}
+
+/* Melds FIRST and its right siblings, all trees, into a single
+   tree and returns its root, or a null pointer if FIRST is
+   null. */
+static struct pqueue_elem *
+merge_pairs (const struct pqueue *pq, struct pqueue_elem *first) 
+{
+  struct pqueue_elem *pairs = NULL;
+  struct pqueue_elem *root = NULL;
+
+  /* Meld adjacent pairs from left to right, stacking the results
+     on PAIRS through their `next' members. */
+  while (first != NULL) 
+    {
+      struct pqueue_elem *a = first;
+      struct pqueue_elem *b = a->next;
+
+      first = b != NULL ? b->next : NULL;
+      a->next = a->prev = NULL;
+      if (b != NULL) 
+        {
+          b->next = b->prev = NULL;
+          a = meld (pq, a, b);
+        }
+      a->next = pairs;
+      pairs = a;
+    }
+
+  /* Meld the pairs from right to left, which is the order they
+     come off the stack. */
+  while (pairs != NULL) 
+    {
+      struct pqueue_elem *p = pairs;
+      pairs = p->next;
+      p->next = NULL;
+      root = meld (pq, root, p);
+    }
+  return root;
+}
+
+/* Unlinks E, which must not be a root, and its subtree from its
+   parent and siblings. */
+static void
+detach (struct pqueue_elem *e) 
+{
+  if (e->prev->child == e)
+    e->prev->child = e->next;
+  else
+    e->prev->next = e->next;
+  if (e->next != NULL)
+    e->next->prev = e->prev;
+  e->next = e->prev = NULL;
+}
+
+/* Links ELEM into PQ as a one-node tree, keeping its sequence
+   number.  Does not adjust the element count. */
+static void
+insert (struct pqueue *pq, struct pqueue_elem *elem) 
+{
+  elem->child = elem->next = elem->prev = NULL;
+  pq->root = meld (pq, pq->root, elem);
+}
+
+/* Unlinks ELEM from PQ, melding its children back in.  Does not
+   adjust the element count. */
+static void
+extract (struct pqueue *pq, struct pqueue_elem *elem) 
+{
+  struct pqueue_elem *children = elem->child;
+
+  elem->child = NULL;
+  if (elem == pq->root)
+    pq->root = merge_pairs (pq, children);
+  else 
+    {
+      detach (elem);
+      pq->root = meld (pq, pq->root, merge_pairs (pq, children));
+    }
+}
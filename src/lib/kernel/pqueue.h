@@ -0,0 +1,73 @@
+#ifndef __LIB_KERNEL_PQUEUE_H
+#define __LIB_KERNEL_PQUEUE_H
+
+/* Priority queue.
+
+   This is a max-first pairing heap.  Pushing an element and
+   finding the maximum take O(1) time, and popping or removing an
+   element takes O(lg n) amortized time.  Elements that compare
+   equal come out in the order they were pushed, so a queue of
+   equal-priority waiters behaves like a FIFO list.
+
+   Like lists and hash tables, priority queues do not use dynamic
+   allocation.  Each structure that can be in a queue embeds a
+   struct pqueue_elem, and pqueue_entry() converts a pointer to
+   that member back into a pointer to the structure.  Refer to
+   lib/kernel/list.h for a detailed explanation of the technique.
+
+   The queue does not notice when an element's key changes.  The
+   owner must call pqueue_update() on the element afterward, or
+   the heap order will be corrupted. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Priority queue element. */
+struct pqueue_elem 
+  {
+    struct pqueue_elem *child;  /* Leftmost child. */
+    struct pqueue_elem *next;   /* Next sibling to the right. */
+    struct pqueue_elem *prev;   /* Left sibling, or parent if leftmost. */
+    unsigned seq;               /* Push order, for breaking ties. */
+  };
+
+/* Converts pointer to priority queue element PQUEUE_ELEM into a
+   pointer to the structure that PQUEUE_ELEM is embedded inside.
+   Supply the name of the outer structure STRUCT and the member
+   name MEMBER of the priority queue element. */
+#define pqueue_entry(PQUEUE_ELEM, STRUCT, MEMBER)               \
+        ((STRUCT *) ((uint8_t *) &(PQUEUE_ELEM)->child          \
+                     - offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two priority queue elements A and B,
+   given auxiliary data AUX.  Returns true if A is less than B,
+   or false if A is greater than or equal to B. */
+typedef bool pqueue_less_func (const struct pqueue_elem *a,
+                               const struct pqueue_elem *b,
+                               void *aux);
+
+/* Priority queue. */
+struct pqueue 
+  {
+    struct pqueue_elem *root;   /* Maximum element, or NULL if empty. */
+    size_t elem_cnt;            /* Number of elements. */
+    unsigned next_seq;          /* Sequence number for next push. */
+    pqueue_less_func *less;     /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+void pqueue_init (struct pqueue *, pqueue_less_func *, void *aux);
+
+/* Insertion and removal. */
+void pqueue_push (struct pqueue *, struct pqueue_elem *);
+struct pqueue_elem *pqueue_pop_max (struct pqueue *);
+void pqueue_remove (struct pqueue *, struct pqueue_elem *);
+void pqueue_update (struct pqueue *, struct pqueue_elem *);
+
+/* Information. */
+struct pqueue_elem *pqueue_max (struct pqueue *);
+size_t pqueue_size (struct pqueue *);
+bool pqueue_empty (struct pqueue *);
+
+#endif /* lib/kernel/pqueue.h */
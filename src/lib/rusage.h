@@ -0,0 +1,16 @@
+#ifndef __LIB_RUSAGE_H
+#define __LIB_RUSAGE_H
+
+/* Scheduling statistics for one thread, as returned to user
+   programs by the getrusage system call. */
+struct rusage
+  {
+    long long run_ticks;        /* Timer ticks spent running. */
+    long long ready_ticks;      /* Timer ticks spent ready to run. */
+    long long blocked_ticks;    /* Timer ticks spent blocked. */
+    int voluntary_switches;     /* Switches away because it blocked. */
+    int involuntary_switches;   /* Switches away while still runnable. */
+    int page_faults;            /* Page faults taken. */
+  };
+
+#endif /* lib/rusage.h */
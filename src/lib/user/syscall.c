@@ -182,3 +182,9 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+int
+getrusage (struct rusage *usage)
+{
+  return syscall1 (SYS_GETRUSAGE, usage);
+}
@@ -0,0 +1,74 @@
+/* Adds timers whose deadlines are exact multiples of 64 ticks,
+   far enough away to start on level 1 of the timing wheel, so
+   that they are cascaded down on the very tick they are due.
+   Checks that each one fires on time, then does the same with
+   timer_sleep(). */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ITERATIONS 3
+#define WHEEL_SLOTS 64
+
+static void
+wake (void *sema_) 
+{
+  sema_up (sema_);
+}
+
+/* Waits for the start of a new tick and returns it. */
+static int64_t
+next_tick (void) 
+{
+  int64_t start = timer_ticks ();
+
+  while (timer_ticks () == start)
+    continue;
+  return timer_ticks ();
+}
+
+/* Returns the second multiple of WHEEL_SLOTS after NOW, which is
+   more than WHEEL_SLOTS ticks away. */
+static int64_t
+aligned_deadline (int64_t now) 
+{
+  return (now / WHEEL_SLOTS + 2) * WHEEL_SLOTS;
+}
+
+void
+test_alarm_cascade (void) 
+{
+  struct semaphore sema;
+  struct timer timer;
+  int i;
+
+  sema_init (&sema, 0);
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      int64_t deadline = aligned_deadline (timer_ticks ());
+
+      timer_add (&timer, deadline, wake, &sema);
+      sema_down (&sema);
+      if (timer_ticks () < deadline)
+        fail ("timer %d fired before tick %lld", i, deadline);
+      if (timer_ticks () > deadline + 1)
+        fail ("timer %d due at tick %lld fired at tick %lld",
+              i, deadline, timer_ticks ());
+      msg ("timer %d fired on time", i);
+    }
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      int64_t start = next_tick ();
+      int64_t deadline = aligned_deadline (start);
+
+      timer_sleep (deadline - start);
+      if (timer_ticks () < deadline)
+        fail ("sleep %d woke up before tick %lld", i, deadline);
+      msg ("sleep %d woke up", i);
+    }
+  pass ();
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-cascade) begin
+(alarm-cascade) timer 0 fired on time
+(alarm-cascade) timer 1 fired on time
+(alarm-cascade) timer 2 fired on time
+(alarm-cascade) sleep 0 woke up
+(alarm-cascade) sleep 1 woke up
+(alarm-cascade) sleep 2 woke up
+(alarm-cascade) PASS
+(alarm-cascade) end
+EOF
+pass;
@@ -0,0 +1,130 @@
+/* Creates 1,000 threads that each sleep once, with wake-up times
+   spread over a few hundred ticks, and verifies that every
+   thread wakes up and that none wakes up early.
+
+   Also reports how long it took to put all of the threads to
+   sleep and how late the wake-ups ran, as a benchmark of the
+   timer's sleep queue with many sleepers. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 1000
+#define SPREAD 256
+
+/* Information about the test. */
+struct thousand_test 
+  {
+    int64_t start;              /* Time from which sleeps are measured. */
+    struct semaphore go;        /* Released once all threads exist. */
+    struct semaphore done;      /* Upped by each thread on wake-up. */
+
+    /* Output. */
+    struct lock output_lock;    /* Lock protecting the fields below. */
+    int early_cnt;              /* Threads that woke up early. */
+    int64_t total_late;         /* Sum of ticks woken late. */
+    int64_t max_late;           /* Largest number of ticks woken late. */
+  };
+
+/* Information about an individual thread in the test. */
+struct thousand_thread 
+  {
+    struct thousand_test *test; /* Info shared between all threads. */
+    int id;                     /* Sleeper ID. */
+  };
+
+static void sleeper (void *);
+
+void
+test_alarm_thousand (void) 
+{
+  struct thousand_test test;
+  struct thousand_thread *threads;
+  int64_t spawn_start, sleep_start;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Creating %d threads to sleep once each.", THREAD_CNT);
+
+  threads = malloc (sizeof *threads * THREAD_CNT);
+  if (threads == NULL)
+    PANIC ("couldn't allocate memory for test");
+
+  sema_init (&test.go, 0);
+  sema_init (&test.done, 0);
+  lock_init (&test.output_lock);
+  test.early_cnt = 0;
+  test.total_late = 0;
+  test.max_late = 0;
+
+  spawn_start = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct thousand_thread *t = threads + i;
+      char name[16];
+
+      t->test = &test;
+      t->id = i;
+
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, t) == TID_ERROR)
+        fail ("creating thread %d failed", i);
+    }
+  msg ("timing: %"PRId64" ticks to create threads", timer_elapsed (spawn_start));
+
+  /* Let every thread go to sleep. */
+  sleep_start = timer_ticks ();
+  test.start = sleep_start;
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_up (&test.go);
+
+  /* Wait for every thread to wake up. */
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&test.done);
+
+  msg ("timing: %"PRId64" ticks from first sleep to last wake-up",
+       timer_elapsed (sleep_start));
+  msg ("timing: wake-ups were %"PRId64" ticks late on average, "
+       "%"PRId64" at most", test.total_late / THREAD_CNT, test.max_late);
+
+  if (test.early_cnt != 0)
+    fail ("%d threads woke up early", test.early_cnt);
+  msg ("All %d threads woke up, none early.", THREAD_CNT);
+
+  free (threads);
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *t_) 
+{
+  struct thousand_thread *t = t_;
+  struct thousand_test *test = t->test;
+  int64_t wake_at, late;
+
+  sema_down (&test->go);
+  wake_at = test->start + 1 + t->id % SPREAD;
+  timer_sleep (wake_at - timer_ticks ());
+  late = timer_ticks () - wake_at;
+
+  lock_acquire (&test->output_lock);
+  if (late < 0)
+    test->early_cnt++;
+  else
+    {
+      test->total_late += late;
+      if (late > test->max_late)
+        test->max_late = late;
+    }
+  lock_release (&test->output_lock);
+
+  sema_up (&test->done);
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Timing lines differ from run to run, so they only need to be
+# present.
+fail "No timing results reported.\n" if !grep (/timing:/, @output);
+@output = grep (!/timing:/, @output);
+
+my (@expected) = ("(alarm-thousand) begin",
+		  "(alarm-thousand) Creating 1000 threads to sleep once each.",
+		  "(alarm-thousand) All 1000 threads woke up, none early.",
+		  "(alarm-thousand) end");
+my (@core) = grep (/^\(alarm-thousand\) /, @output);
+fail "Output differs from expected:\n" . join ("\n", @core) . "\n"
+  if join ("\n", @core) ne join ("\n", @expected);
+pass;
@@ -0,0 +1,80 @@
+/* Run with -tickless.  Two threads sleep for different lengths
+   of time, several times over, while nothing else runs, so the
+   timer skips the ticks in between.  Checks that every sleeper
+   wakes up on time, that the idle ticks were not charged to the
+   sleepers, and that some timer interrupts were in fact
+   avoided. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ITERATIONS 5
+
+struct sleeper 
+  {
+    int64_t duration;           /* Ticks to sleep each time. */
+    int late;                   /* Wake-ups more than a tick late. */
+    int early;                  /* Wake-ups before the deadline. */
+    long long run_ticks;        /* Ticks it was charged for. */
+    struct semaphore done;      /* Up'd when it has finished. */
+  };
+
+static void
+sleep_repeatedly (void *s_) 
+{
+  struct sleeper *s = s_;
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) 
+    {
+      int64_t deadline = timer_ticks () + s->duration;
+
+      timer_sleep (s->duration);
+      if (timer_ticks () < deadline)
+        s->early++;
+      else if (timer_ticks () > deadline + 1)
+        s->late++;
+    }
+  s->run_ticks = thread_current ()->usage.run_ticks;
+  sema_up (&s->done);
+}
+
+void
+test_alarm_tickless (void) 
+{
+  struct sleeper sleepers[2];
+  int64_t avoided = timer_ticks_avoided ();
+  int i;
+
+  ASSERT (timer_tickless);
+
+  for (i = 0; i < 2; i++) 
+    {
+      sleepers[i].duration = 13 + 24 * i;
+      sleepers[i].late = sleepers[i].early = 0;
+      sema_init (&sleepers[i].done, 0);
+      thread_create ("sleeper", PRI_DEFAULT, sleep_repeatedly, &sleepers[i]);
+    }
+  for (i = 0; i < 2; i++) 
+    {
+      struct sleeper *s = &sleepers[i];
+
+      sema_down (&s->done);
+      if (s->early > 0)
+        fail ("sleeper %d woke up early %d times", i, s->early);
+      if (s->late > 0)
+        fail ("sleeper %d woke up late %d times", i, s->late);
+      if (s->run_ticks > ITERATIONS)
+        fail ("sleeper %d charged for %lld ticks while mostly asleep",
+              i, s->run_ticks);
+      msg ("sleeper %d woke up on time", i);
+    }
+
+  if (timer_ticks_avoided () == avoided)
+    fail ("no timer interrupts avoided");
+  msg ("timer interrupts avoided");
+  pass ();
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-tickless) begin
+(alarm-tickless) sleeper 0 woke up on time
+(alarm-tickless) sleeper 1 woke up on time
+(alarm-tickless) timer interrupts avoided
+(alarm-tickless) PASS
+(alarm-tickless) end
+EOF
+pass;
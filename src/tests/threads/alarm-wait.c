@@ -23,7 +23,7 @@ test_alarm_multiple (void)
 {
   test_sleep (5, 7);
 }
-
+
 /* Information about the test. */
 struct sleep_test 
   {
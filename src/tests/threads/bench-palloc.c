@@ -0,0 +1,143 @@
+/* Page allocator benchmark.  Repeatedly fills the user pool with
+   runs of 1 to 8 pages until an allocation fails, then frees a
+   random half of the runs, and reports how fragmented the pool
+   was at each failure and how long allocations and frees took.
+   Make.tests runs it with user pools of several sizes.
+
+   Fragmentation and timings depend on the pool size, so they are
+   reported on "fragmentation:" and "timing:" lines.  The test
+   itself checks only that no two runs overlap and that all the
+   free pages coalesce again once everything is freed. */
+
+#include <stdio.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+#define MAX_RUN 8               /* Most pages in one run. */
+#define ROUND_CNT 8             /* Times to fill up the pool. */
+
+/* A run of allocated pages. */
+struct run 
+  {
+    uint8_t *pages;             /* First page. */
+    size_t page_cnt;            /* Number of pages. */
+  };
+
+static void tag_run (struct run *, size_t tag);
+static void check_run (struct run *, size_t tag);
+
+void
+test_bench_palloc (void) 
+{
+  struct run *runs;
+  size_t run_cnt = 0;
+  size_t free_cnt, largest_cnt, free0_cnt, largest0_cnt;
+  uint64_t alloc_time = 0, free_time = 0;
+  unsigned alloc_cnt = 0, free_op_cnt = 0;
+  int round;
+  size_t i;
+
+  palloc_get_stats (PAL_USER, &free0_cnt, &largest0_cnt);
+  msg ("Filling the user pool with runs of 1 to %d pages.", MAX_RUN);
+  msg ("timing: %zu pages in user pool, largest free block %zu",
+       free0_cnt, largest0_cnt);
+
+  runs = malloc (sizeof *runs * (free0_cnt + 1));
+  if (runs == NULL)
+    fail ("couldn't allocate memory for test");
+  random_init (0);
+
+  for (round = 0; round < ROUND_CNT; round++) 
+    {
+      /* Fill. */
+      for (;;) 
+        {
+          struct run *r = &runs[run_cnt];
+          size_t page_cnt = random_ulong () % MAX_RUN + 1;
+          uint64_t start = thread_clock ();
+
+          r->pages = palloc_get_multiple (PAL_USER, page_cnt);
+          alloc_time += thread_clock () - start;
+          alloc_cnt++;
+          if (r->pages == NULL) 
+            {
+              palloc_get_stats (PAL_USER, &free_cnt, &largest_cnt);
+              msg ("fragmentation: round %d: %zu-page request failed with "
+                   "%zu pages free, largest block %zu",
+                   round, page_cnt, free_cnt, largest_cnt);
+              break;
+            }
+          r->page_cnt = page_cnt;
+          tag_run (r, run_cnt);
+          run_cnt++;
+        }
+
+      /* Free a random half of the runs. */
+      for (i = 0; i < run_cnt; ) 
+        if (random_ulong () % 2) 
+          {
+            uint64_t start;
+
+            check_run (&runs[i], i);
+            start = thread_clock ();
+            palloc_free_multiple (runs[i].pages, runs[i].page_cnt);
+            free_time += thread_clock () - start;
+            free_op_cnt++;
+
+            /* Move the last run into this slot. */
+            runs[i] = runs[--run_cnt];
+            if (i < run_cnt)
+              tag_run (&runs[i], i);
+          }
+        else
+          i++;
+    }
+
+  /* Free everything that is left. */
+  for (i = 0; i < run_cnt; i++) 
+    {
+      check_run (&runs[i], i);
+      palloc_free_multiple (runs[i].pages, runs[i].page_cnt);
+    }
+  free (runs);
+  msg ("No two runs overlapped.");
+
+  palloc_get_stats (PAL_USER, &free_cnt, &largest_cnt);
+  if (free_cnt != free0_cnt || largest_cnt != largest0_cnt)
+    fail ("after freeing everything, %zu pages free with largest block %zu, "
+          "but started with %zu and %zu",
+          free_cnt, largest_cnt, free0_cnt, largest0_cnt);
+  msg ("Free pages coalesced back into the original blocks.");
+
+  msg ("timing: %llu %s per allocation, %llu %s per free",
+       alloc_time / alloc_cnt, thread_clock_unit (),
+       free_op_cnt > 0 ? free_time / free_op_cnt : 0, thread_clock_unit ());
+}
+
+/* Stores TAG at the start of every page in run R. */
+static void
+tag_run (struct run *r, size_t tag) 
+{
+  size_t i;
+
+  for (i = 0; i < r->page_cnt; i++)
+    *(size_t *) (r->pages + i * PGSIZE) = tag;
+}
+
+/* Checks that every page in run R still has TAG at its start,
+   which it would not if another run had been given the same
+   page. */
+static void
+check_run (struct run *r, size_t tag) 
+{
+  size_t i;
+
+  for (i = 0; i < r->page_cnt; i++)
+    if (*(size_t *) (r->pages + i * PGSIZE) != tag)
+      fail ("page %zu of run %zu was overwritten", i, tag);
+}
@@ -0,0 +1,95 @@
+/* Compares the throughput of readers sharing an rwlock with that
+   of the same readers serialized by a plain lock.  Each reader
+   repeatedly holds the lock while it sleeps for a couple of
+   ticks, standing in for a read-side critical section that
+   blocks, e.g. on disk I/O.
+
+   The elapsed times depend on timer interrupts, so they are
+   reported on "timing:" lines, and the test only checks that the
+   readers finished at least twice as fast with the rwlock. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define READER_CNT 8
+#define ITER_CNT 5
+#define HOLD_TICKS 2
+
+struct bench
+  {
+    bool use_rwlock;            /* Use RW, or LOCK? */
+    struct rwlock rw;
+    struct lock lock;
+    struct semaphore done;      /* Upped by each reader when done. */
+  };
+
+static int64_t run_readers (struct bench *);
+static thread_func reader;
+
+void
+test_bench_rwlock (void) 
+{
+  struct bench b;
+  int64_t lock_ticks, rw_ticks;
+
+  rwlock_init (&b.rw);
+  lock_init (&b.lock);
+  sema_init (&b.done, 0);
+
+  msg ("Running %d readers with a lock.", READER_CNT);
+  b.use_rwlock = false;
+  lock_ticks = run_readers (&b);
+  msg ("timing: %"PRId64" ticks with a lock", lock_ticks);
+
+  msg ("Running %d readers with an rwlock.", READER_CNT);
+  b.use_rwlock = true;
+  rw_ticks = run_readers (&b);
+  msg ("timing: %"PRId64" ticks with an rwlock", rw_ticks);
+
+  if (rw_ticks * 2 > lock_ticks)
+    fail ("readers were not at least twice as fast with an rwlock");
+  msg ("Readers ran concurrently with the rwlock.");
+}
+
+/* Runs READER_CNT readers to completion and returns the ticks
+   they took. */
+static int64_t
+run_readers (struct bench *b) 
+{
+  int64_t start = timer_ticks ();
+  int i;
+
+  for (i = 0; i < READER_CNT; i++)
+    thread_create ("reader", PRI_DEFAULT, reader, b);
+  for (i = 0; i < READER_CNT; i++)
+    sema_down (&b->done);
+  return timer_elapsed (start);
+}
+
+static void
+reader (void *b_) 
+{
+  struct bench *b = b_;
+  int i;
+
+  for (i = 0; i < ITER_CNT; i++)
+    {
+      if (b->use_rwlock)
+        rw_read_acquire (&b->rw);
+      else
+        lock_acquire (&b->lock);
+
+      timer_sleep (HOLD_TICKS);
+
+      if (b->use_rwlock)
+        rw_read_release (&b->rw);
+      else
+        lock_release (&b->lock);
+    }
+  sema_up (&b->done);
+}
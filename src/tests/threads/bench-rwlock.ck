@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Timing lines differ from run to run, so they only need to be
+# present.
+fail "No timing results reported.\n" if !grep (/timing:/, @output);
+@output = grep (!/timing:/, @output);
+
+my (@expected) = ("(bench-rwlock) begin",
+		  "(bench-rwlock) Running 8 readers with a lock.",
+		  "(bench-rwlock) Running 8 readers with an rwlock.",
+		  "(bench-rwlock) Readers ran concurrently with the rwlock.",
+		  "(bench-rwlock) end");
+my (@core) = grep (/^\(bench-rwlock\) /, @output);
+fail "Output differs from expected:\n" . join ("\n", @core) . "\n"
+  if join ("\n", @core) ne join ("\n", @expected);
+pass;
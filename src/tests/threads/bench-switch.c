@@ -0,0 +1,104 @@
+/* Counts the context switches taken by two workloads that wake
+   or create threads of the same priority as the running thread:
+   a producer handing items to a consumer through a semaphore, and
+   a spawner creating short-lived threads.  The woken or created
+   threads never have priority over the running thread, so
+   neither workload should need a switch per item: a thread that
+   yielded after every sema_up() or thread_create() would take at
+   least one switch per item.
+
+   The counts vary with timer interrupts, so they are reported on
+   "timing:" lines, and the test only checks that each stays under
+   a tenth of the number of items. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define ITEM_CNT 1000
+#define SPAWN_CNT 100
+
+struct consumer_info
+  {
+    struct semaphore items;     /* Items produced. */
+    struct semaphore done;      /* Upped when all are consumed. */
+    struct rusage usage;        /* Consumer's statistics at the end. */
+  };
+
+static thread_func consumer;
+static thread_func spawnee;
+static int switches (const struct rusage *);
+
+void
+test_bench_switch (void) 
+{
+  struct consumer_info info;
+  struct semaphore done;
+  struct rusage before, after;
+  int producer_switches, consumer_switches, spawner_switches;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Producing %d items for a consumer.", ITEM_CNT);
+  sema_init (&info.items, 0);
+  sema_init (&info.done, 0);
+  thread_create ("consumer", PRI_DEFAULT, consumer, &info);
+  thread_get_rusage (&before);
+  for (i = 0; i < ITEM_CNT; i++)
+    sema_up (&info.items);
+  thread_get_rusage (&after);
+  sema_down (&info.done);
+  producer_switches = switches (&after) - switches (&before);
+  consumer_switches = switches (&info.usage);
+  msg ("timing: %d producer and %d consumer context switches",
+       producer_switches, consumer_switches);
+  if (producer_switches + consumer_switches >= ITEM_CNT / 10)
+    fail ("too many context switches for %d items", ITEM_CNT);
+
+  msg ("Spawning %d threads.", SPAWN_CNT);
+  sema_init (&done, 0);
+  thread_get_rusage (&before);
+  for (i = 0; i < SPAWN_CNT; i++)
+    thread_create ("spawnee", PRI_DEFAULT, spawnee, &done);
+  thread_get_rusage (&after);
+  for (i = 0; i < SPAWN_CNT; i++)
+    sema_down (&done);
+  spawner_switches = switches (&after) - switches (&before);
+  msg ("timing: %d spawner context switches", spawner_switches);
+  if (spawner_switches >= SPAWN_CNT / 10)
+    fail ("too many context switches for %d spawns", SPAWN_CNT);
+
+  msg ("Context switches were not needed per item.");
+}
+
+/* Consumes ITEM_CNT items, then reports its statistics. */
+static void
+consumer (void *info_) 
+{
+  struct consumer_info *info = info_;
+  int i;
+
+  for (i = 0; i < ITEM_CNT; i++)
+    sema_down (&info->items);
+  thread_get_rusage (&info->usage);
+  sema_up (&info->done);
+}
+
+static void
+spawnee (void *done_) 
+{
+  struct semaphore *done = done_;
+
+  sema_up (done);
+}
+
+/* Returns the context switches counted in U. */
+static int
+switches (const struct rusage *u) 
+{
+  return u->voluntary_switches + u->involuntary_switches;
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Switch counts differ from run to run, so they only need to be
+# present.
+fail "No context switch counts reported.\n" if !grep (/timing:/, @output);
+@output = grep (!/timing:/, @output);
+
+my (@expected) = ("(bench-switch) begin",
+		  "(bench-switch) Producing 1000 items for a consumer.",
+		  "(bench-switch) Spawning 100 threads.",
+		  "(bench-switch) Context switches were not needed per item.",
+		  "(bench-switch) end");
+my (@core) = grep (/^\(bench-switch\) /, @output);
+fail "Output differs from expected:\n" . join ("\n", @core) . "\n"
+  if join ("\n", @core) ne join ("\n", @expected);
+pass;
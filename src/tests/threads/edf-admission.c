@@ -0,0 +1,69 @@
+/* Checks that thread_set_realtime() admits real-time threads only
+   while their total utilization stays within 100%, and that
+   utilization is given back when a thread leaves the real-time
+   class or exits. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct admit_info
+  {
+    int64_t period;             /* Period to ask for. */
+    int64_t budget;             /* Budget to ask for. */
+    bool admitted;              /* Result. */
+    struct semaphore ack;       /* Upped once admission is tried. */
+    struct semaphore release;   /* Lets an admitted thread exit. */
+  };
+
+static void admit (struct admit_info *, int64_t period, int64_t budget);
+static thread_func admit_thread;
+
+void
+test_edf_admission (void) 
+{
+  struct admit_info a, b, c, d, e, f;
+
+  admit (&a, 10, 5);
+  admit (&b, 10, 6);
+  admit (&c, 10, 5);
+  admit (&d, 100, 1);
+  admit (&e, 10, 11);
+
+  msg ("Releasing admitted threads.");
+  sema_up (&a.release);
+  sema_up (&c.release);
+
+  admit (&f, 10, 10);
+  sema_up (&f.release);
+}
+
+/* Creates a thread that asks to be admitted as a real-time
+   thread with the given PERIOD and BUDGET, and reports whether it
+   was.  An admitted thread stays in the real-time class until
+   INFO->release is upped. */
+static void
+admit (struct admit_info *info, int64_t period, int64_t budget) 
+{
+  info->period = period;
+  info->budget = budget;
+  sema_init (&info->ack, 0);
+  sema_init (&info->release, 0);
+  thread_create ("admit", PRI_DEFAULT, admit_thread, info);
+  sema_down (&info->ack);
+  msg ("Period %d, budget %d: %s.", (int) period, (int) budget,
+       info->admitted ? "admitted" : "rejected");
+}
+
+static void
+admit_thread (void *info_) 
+{
+  struct admit_info *info = info_;
+
+  info->admitted = thread_set_realtime (info->period, info->budget);
+  sema_up (&info->ack);
+  if (info->admitted)
+    sema_down (&info->release);
+}
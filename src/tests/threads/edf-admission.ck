@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-admission) begin
+(edf-admission) Period 10, budget 5: admitted.
+(edf-admission) Period 10, budget 6: rejected.
+(edf-admission) Period 10, budget 5: admitted.
+(edf-admission) Period 100, budget 1: rejected.
+(edf-admission) Period 10, budget 11: rejected.
+(edf-admission) Releasing admitted threads.
+(edf-admission) Period 10, budget 10: admitted.
+(edf-admission) end
+EOF
+pass;
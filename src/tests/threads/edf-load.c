@@ -0,0 +1,131 @@
+/* Runs four real-time threads alongside two busy ordinary
+   threads, and reports the deadlines each real-time thread
+   missed.
+
+   Three of the real-time threads do a little less work in each
+   period than their budgets allow, and together use under 100%
+   of the CPU, so under EDF they should miss no deadlines, however
+   busy the ordinary threads keep the CPU.  The fourth needs more
+   than twice its budget for each job, so it misses deadlines, but
+   budget enforcement keeps it from making the others miss
+   any. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+struct rt_info
+  {
+    int64_t period;             /* Period, in ticks. */
+    int64_t budget;             /* Budget per period, in ticks. */
+    int work;                   /* Ticks of work per job. */
+    int jobs;                   /* Jobs to run. */
+    int missed;                 /* Deadlines missed. */
+    struct semaphore *done;     /* Upped when all jobs are run. */
+  };
+
+#define RT_CNT 4
+#define LOAD_CNT 2
+
+static thread_func rt_thread;
+static thread_func load_thread;
+static void spin_ticks (int ticks);
+
+static volatile bool stop;
+
+void
+test_edf_load (void) 
+{
+  struct rt_info info[RT_CNT] =
+    {
+      {10, 3, 2, 40, 0, NULL},
+      {20, 5, 4, 20, 0, NULL},
+      {40, 10, 8, 10, 0, NULL},
+      {20, 2, 5, 3, 0, NULL},   /* Overruns its budget. */
+    };
+  struct semaphore done;
+  int i;
+
+  sema_init (&done, 0);
+  stop = false;
+
+  msg ("Starting %d real-time threads...", RT_CNT);
+  for (i = 0; i < RT_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "rt %d", i);
+      info[i].done = &done;
+      thread_create (name, PRI_DEFAULT, rt_thread, &info[i]);
+    }
+
+  msg ("Starting %d busy threads...", LOAD_CNT);
+  for (i = 0; i < LOAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, &done);
+    }
+
+  for (i = 0; i < RT_CNT; i++)
+    sema_down (&done);
+  stop = true;
+  for (i = 0; i < LOAD_CNT; i++)
+    sema_down (&done);
+
+  for (i = 0; i < RT_CNT - 1; i++)
+    msg ("Real-time thread %d missed %d deadlines.", i, info[i].missed);
+  msg ("Overrunning thread %s deadlines.",
+       info[RT_CNT - 1].missed > 0 ? "missed" : "did not miss");
+}
+
+/* Runs the jobs for the rt_info passed as INFO_, one per period. */
+static void
+rt_thread (void *info_) 
+{
+  struct rt_info *info = info_;
+  int i;
+
+  if (!thread_set_realtime (info->period, info->budget))
+    fail ("real-time thread not admitted");
+
+  /* Start on a period boundary. */
+  thread_wait_next_period ();
+  for (i = 0; i < info->jobs; i++)
+    {
+      spin_ticks (info->work);
+      thread_wait_next_period ();
+    }
+
+  info->missed = thread_get_rt_missed ();
+  thread_set_realtime (0, 0);
+  sema_up (info->done);
+}
+
+/* Keeps the CPU busy until told to stop. */
+static void
+load_thread (void *done_) 
+{
+  struct semaphore *done = done_;
+
+  while (!stop)
+    continue;
+  sema_up (done);
+}
+
+/* Spins until TICKS timer ticks have been seen while running. */
+static void
+spin_ticks (int ticks) 
+{
+  int64_t last_time = timer_ticks ();
+
+  while (ticks > 0)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ticks--;
+      last_time = cur_time;
+    }
+}
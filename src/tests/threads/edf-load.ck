@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-load) begin
+(edf-load) Starting 4 real-time threads...
+(edf-load) Starting 2 busy threads...
+(edf-load) Real-time thread 0 missed 0 deadlines.
+(edf-load) Real-time thread 1 missed 0 deadlines.
+(edf-load) Real-time thread 2 missed 0 deadlines.
+(edf-load) Overrunning thread missed deadlines.
+(edf-load) end
+EOF
+pass;
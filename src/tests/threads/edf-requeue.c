@@ -0,0 +1,109 @@
+/* Checks that real-time threads that miss a deadline while
+   waiting to run are dispatched in the order of their new
+   deadlines.
+
+   Threads A (period 30), B (period 20) and C (period 60) join the
+   real-time class in the same tick, so all of their periods end
+   together 60 ticks later.  A little before then, C, A and B are
+   woken in that order, all with the same deadline, so C runs and
+   A and B wait behind it in that order.  C keeps running past the
+   deadline, which A and B therefore both miss.  Their next
+   deadlines are then 30 and 20 ticks away, so B must run before
+   A. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+struct rt_info
+  {
+    const char *name;           /* Thread name. */
+    int64_t period;             /* Period, in ticks. */
+    int64_t budget;             /* Budget per period, in ticks. */
+    int64_t start;              /* Tick it joined the real-time class. */
+    struct semaphore *go;       /* Upped to start its job. */
+    struct semaphore *done;     /* Upped when its job is done. */
+  };
+
+#define RT_CNT 3
+#define HYPERPERIOD 60
+#define WAKE_EARLY 5
+
+static thread_func rt_thread;
+
+/* End of the shared period, which C spins past. */
+static int64_t deadline;
+
+void
+test_edf_requeue (void) 
+{
+  struct rt_info info[RT_CNT] =
+    {
+      {"A", 30, 10, 0, NULL, NULL},
+      {"B", 20, 5, 0, NULL, NULL},
+      {"C", 60, 20, 0, NULL, NULL},
+    };
+  struct semaphore go[RT_CNT];
+  struct semaphore done;
+  enum intr_level old_level;
+  int i;
+
+  sema_init (&done, 0);
+
+  /* Start at the beginning of a tick, so that all the threads can
+     join the real-time class within it. */
+  timer_sleep (1);
+  for (i = 0; i < RT_CNT; i++) 
+    {
+      sema_init (&go[i], 0);
+      info[i].go = &go[i];
+      info[i].done = &done;
+      thread_create (info[i].name, PRI_DEFAULT + 1, rt_thread, &info[i]);
+    }
+  for (i = 1; i < RT_CNT; i++)
+    if (info[i].start != info[0].start)
+      fail ("real-time threads started in ticks %lld and %lld",
+            info[0].start, info[i].start);
+  deadline = info[0].start + HYPERPERIOD;
+
+  /* Wake C, A, B with interrupts off, so that none of them runs
+     before all are queued, then let C run. */
+  timer_sleep (deadline - WAKE_EARLY - timer_ticks ());
+  old_level = intr_disable ();
+  sema_up (&go[2]);
+  sema_up (&go[0]);
+  sema_up (&go[1]);
+  intr_set_level (old_level);
+  thread_yield ();
+
+  for (i = 0; i < RT_CNT; i++)
+    sema_down (&done);
+}
+
+static void
+rt_thread (void *info_) 
+{
+  struct rt_info *info = info_;
+
+  if (!thread_set_realtime (info->period, info->budget))
+    fail ("real-time thread %s not admitted", info->name);
+  info->start = timer_ticks ();
+
+  sema_down (info->go);
+  if (info->period == HYPERPERIOD)
+    {
+      /* Hold the CPU until the others have missed their deadline. */
+      while (timer_ticks () <= deadline)
+        continue;
+    }
+  else
+    msg ("Thread %s dispatched, %s deadlines.", info->name,
+         thread_get_rt_missed () > 0 ? "missed" : "did not miss");
+
+  thread_set_realtime (0, 0);
+  sema_up (info->done);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-requeue) begin
+(edf-requeue) Thread B dispatched, missed deadlines.
+(edf-requeue) Thread A dispatched, missed deadlines.
+(edf-requeue) end
+EOF
+pass;
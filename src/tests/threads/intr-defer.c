@@ -0,0 +1,76 @@
+/* Checks both kinds of deferred work.  A timer function, which
+   runs in interrupt context, queues one item with intr_defer() and
+   one with intr_defer_to_worker().  The first must run before the
+   interrupt returns, still in interrupt context but with
+   interrupts on.  The second must run in a worker thread, where
+   it may sleep.  The kernel starts no worker threads until they
+   are needed, and a timer function cannot create them, so this
+   test starts them itself. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static struct semaphore done;
+static struct intr_work softirq_work, worker_work;
+static bool softirq_in_context, softirq_intr_on;
+static bool worker_in_context;
+static tid_t worker_tid;
+
+static void expire (void *);
+static void softirq_func (void *);
+static void worker_func (void *);
+
+void
+test_intr_defer (void) 
+{
+  struct timer timer;
+
+  sema_init (&done, 0);
+  intr_work_init (&softirq_work, softirq_func, NULL);
+  intr_work_init (&worker_work, worker_func, NULL);
+  intr_workers_start ();
+
+  timer_add (&timer, timer_ticks () + 1, expire, NULL);
+  sema_down (&done);
+  sema_down (&done);
+
+  if (!softirq_in_context || !softirq_intr_on)
+    fail ("deferred work ran %s interrupt context with interrupts %s",
+          softirq_in_context ? "in" : "outside",
+          softirq_intr_on ? "on" : "off");
+  msg ("Deferred work ran in interrupt context with interrupts on.");
+
+  if (worker_in_context || worker_tid == thread_tid ())
+    fail ("worker item did not run in a worker thread");
+  msg ("Worker item ran in a worker thread and slept.");
+}
+
+/* Timer function: queues both work items. */
+static void
+expire (void *aux UNUSED) 
+{
+  intr_defer (&softirq_work);
+  intr_defer_to_worker (&worker_work);
+}
+
+static void
+softirq_func (void *aux UNUSED) 
+{
+  softirq_in_context = intr_context ();
+  softirq_intr_on = intr_get_level () == INTR_ON;
+  sema_up (&done);
+}
+
+static void
+worker_func (void *aux UNUSED) 
+{
+  worker_in_context = intr_context ();
+  worker_tid = thread_tid ();
+  timer_sleep (1);
+  sema_up (&done);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(intr-defer) begin
+(intr-defer) Deferred work ran in interrupt context with interrupts on.
+(intr-defer) Worker item ran in a worker thread and slept.
+(intr-defer) end
+EOF
+pass;
@@ -0,0 +1,97 @@
+/* Allocates many small objects from an object cache, checks that
+   they are distinct and were constructed, then frees them all and
+   checks that the cache gives its pages back, keeping one slab. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
+
+#define OBJ_CNT 500
+#define CTOR_MAGIC 0x0b1ec7ed
+
+struct obj 
+  {
+    unsigned magic;             /* Set by the constructor. */
+    int id;                     /* Index in the test's array. */
+    char pad[32];
+  };
+
+/* Registered caches are never unregistered, so this one must not
+   live on the stack. */
+static struct kmem_cache cache;
+static size_t ctor_cnt;
+
+static void
+obj_ctor (void *obj_) 
+{
+  struct obj *obj = obj_;
+  obj->magic = CTOR_MAGIC;
+  obj->id = -1;
+  ctor_cnt++;
+}
+
+void
+test_kmem_cache (void) 
+{
+  struct obj **objs;
+  size_t free_before, free_after, largest;
+  size_t slabs, ctors;
+  int i;
+
+  objs = malloc (OBJ_CNT * sizeof *objs);
+  ASSERT (objs != NULL);
+
+  kmem_cache_init (&cache, "test object", sizeof (struct obj), obj_ctor);
+  palloc_get_stats (0, &free_before, &largest);
+
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      objs[i] = kmem_cache_alloc (&cache);
+      if (objs[i] == NULL)
+        fail ("allocation %d failed", i);
+      if (objs[i]->magic != CTOR_MAGIC || objs[i]->id != -1)
+        fail ("object %d was not constructed", i);
+      objs[i]->id = i;
+    }
+  for (i = 0; i < OBJ_CNT; i++)
+    if (objs[i]->id != i)
+      fail ("object %d overlaps object %d", i, objs[i]->id);
+  msg ("Allocated %d constructed, distinct objects.", OBJ_CNT);
+
+  slabs = cache.slab_cnt;
+  if (ctor_cnt != slabs * cache.objs_per_slab)
+    fail ("%zu constructor calls for %zu slabs of %zu objects",
+          ctor_cnt, slabs, cache.objs_per_slab);
+  if (slabs != (OBJ_CNT + cache.objs_per_slab - 1) / cache.objs_per_slab)
+    fail ("%zu slabs for %d objects of %zu per slab",
+          slabs, OBJ_CNT, cache.objs_per_slab);
+  msg ("Constructor ran once per object in each new slab.");
+
+  /* Objects go back in their constructed state. */
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      objs[i]->id = -1;
+      kmem_cache_free (&cache, objs[i]);
+    }
+  palloc_get_stats (0, &free_after, &largest);
+  if (cache.in_use != 0 || cache.slab_cnt != 1)
+    fail ("%zu objects in use and %zu slabs left after freeing all",
+          cache.in_use, cache.slab_cnt);
+  if (free_after + 1 != free_before)
+    fail ("%zu free pages before, %zu after", free_before, free_after);
+  msg ("Freeing everything left one slab.");
+
+  /* The remaining slab is reused without constructing again. */
+  ctors = ctor_cnt;
+  objs[0] = kmem_cache_alloc (&cache);
+  if (objs[0] == NULL || objs[0]->magic != CTOR_MAGIC || ctor_cnt != ctors)
+    fail ("cached slab was not reused");
+  kmem_cache_free (&cache, objs[0]);
+  msg ("Cached slab was reused.");
+
+  free (objs);
+}
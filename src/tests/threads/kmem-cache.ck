@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(kmem-cache) begin
+(kmem-cache) Allocated 500 constructed, distinct objects.
+(kmem-cache) Constructor ran once per object in each new slab.
+(kmem-cache) Freeing everything left one slab.
+(kmem-cache) Cached slab was reused.
+(kmem-cache) end
+EOF
+pass;
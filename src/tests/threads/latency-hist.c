@@ -0,0 +1,80 @@
+/* Checks the wakeup latency histograms.  Two threads at known
+   priorities above the main thread's are woken a fixed number of
+   times each, which must add exactly that many samples to their
+   priorities' histograms, and thread_reset_latency() must clear
+   them again. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define WAKER_CNT 2
+#define ITERATIONS 5
+
+static struct semaphore wake[WAKER_CNT];
+
+static thread_func waker_func;
+static void check_counts (unsigned expected);
+
+void
+test_latency_hist (void) 
+{
+  int i, j;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Each waker preempts us, so its creation has been recorded
+     by the time thread_create() returns. */
+  for (i = 0; i < WAKER_CNT; i++)
+    {
+      char name[16];
+      sema_init (&wake[i], 0);
+      snprintf (name, sizeof name, "waker %d", i);
+      thread_create (name, PRI_DEFAULT + 1 + i, waker_func, &wake[i]);
+    }
+  for (i = 0; i < WAKER_CNT; i++)
+    if (thread_latency_count (PRI_DEFAULT + 1 + i) == 0)
+      fail ("priority %d recorded no wakeup on creation", PRI_DEFAULT + 1 + i);
+
+  thread_reset_latency ();
+  check_counts (0);
+  msg ("Reset cleared the histograms.");
+
+  for (i = 0; i < ITERATIONS; i++)
+    for (j = 0; j < WAKER_CNT; j++)
+      sema_up (&wake[j]);
+  check_counts (ITERATIONS);
+  msg ("Each priority recorded %d wakeups.", ITERATIONS);
+
+  thread_reset_latency ();
+  check_counts (0);
+  msg ("Reset cleared the histograms again.");
+}
+
+/* Fails unless each waker's priority has EXPECTED samples. */
+static void
+check_counts (unsigned expected) 
+{
+  int i;
+
+  for (i = 0; i < WAKER_CNT; i++)
+    {
+      unsigned cnt = thread_latency_count (PRI_DEFAULT + 1 + i);
+      if (cnt != expected)
+        fail ("priority %d has %u samples, expected %u",
+              PRI_DEFAULT + 1 + i, cnt, expected);
+    }
+}
+
+static void
+waker_func (void *wake_) 
+{
+  struct semaphore *wake = wake_;
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++)
+    sema_down (wake);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(latency-hist) begin
+(latency-hist) Reset cleared the histograms.
+(latency-hist) Each priority recorded 5 wakeups.
+(latency-hist) Reset cleared the histograms again.
+(latency-hist) end
+EOF
+pass;
@@ -0,0 +1,52 @@
+/* Checks the contention statistics kept for a named lock when
+   the kernel runs with -lockstat.  The main thread holds the
+   lock while it sleeps, and a higher-priority thread has to
+   wait for it in the meantime. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define HOLD_TICKS 5
+
+/* Registered locks are never unregistered, so this one must not
+   live on the stack. */
+static struct lock lock;
+
+static thread_func waiter_func;
+
+void
+test_lock_stats (void) 
+{
+  struct lock_stat *s = &lock.stat;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+  ASSERT (lock_stat_top > 0);
+
+  lock_init_named (&lock, "test lock");
+  lock_acquire (&lock);
+  thread_create ("waiter", PRI_DEFAULT + 1, waiter_func, NULL);
+  timer_sleep (HOLD_TICKS);
+  lock_release (&lock);
+
+  msg ("Acquisitions: %u.", s->acquisitions);
+  msg ("Contended acquisitions: %u.", s->contended);
+  if (s->max_wait < HOLD_TICKS || s->wait_ticks < s->max_wait)
+    fail ("waiter waited %lld ticks in total, at most %lld at once",
+          s->wait_ticks, s->max_wait);
+  if (s->max_hold < HOLD_TICKS)
+    fail ("lock was held for at most %lld ticks", s->max_hold);
+  msg ("Wait and hold times cover the sleep.");
+}
+
+static void
+waiter_func (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  msg ("waiter: got the lock");
+  lock_release (&lock);
+}
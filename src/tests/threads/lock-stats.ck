@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(lock-stats) begin
+(lock-stats) waiter: got the lock
+(lock-stats) Acquisitions: 2.
+(lock-stats) Contended acquisitions: 1.
+(lock-stats) Wait and hold times cover the sleep.
+(lock-stats) end
+EOF
+pass;
@@ -0,0 +1,103 @@
+/* Allocates blocks of many sizes, including ones that fall in
+   multi-page arenas and ones too big for any size class, fills
+   each with its own pattern, and checks that none of them
+   overlap.  Then frees and reallocates half of them, grows some
+   with realloc(), and checks that freeing everything gives all of
+   the pages back. */
+
+#include <stdio.h>
+#include <random.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+
+#define BLOCK_CNT 200           /* Blocks allocated at once. */
+#define MAX_SIZE 5000           /* Largest block size. */
+
+/* An allocated block. */
+struct block 
+  {
+    uint8_t *p;                 /* Block. */
+    size_t size;                /* Bytes requested. */
+  };
+
+static void alloc_block (struct block *, size_t idx);
+static void check_block (struct block *, size_t idx);
+
+void
+test_malloc_sizes (void) 
+{
+  struct block *blocks;
+  size_t free_before, free_after, largest;
+  size_t i;
+
+  blocks = malloc (BLOCK_CNT * sizeof *blocks);
+  ASSERT (blocks != NULL);
+  palloc_get_stats (0, &free_before, &largest);
+
+  random_init (0);
+  for (i = 0; i < BLOCK_CNT; i++)
+    alloc_block (&blocks[i], i);
+  for (i = 0; i < BLOCK_CNT; i++)
+    check_block (&blocks[i], i);
+  msg ("Allocated %d blocks of 1 to %d bytes.", BLOCK_CNT, MAX_SIZE);
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    if (random_ulong () % 2) 
+      {
+        free (blocks[i].p);
+        alloc_block (&blocks[i], i);
+      }
+  for (i = 0; i < BLOCK_CNT; i++)
+    check_block (&blocks[i], i);
+  msg ("Reallocated a random half of them.");
+
+  for (i = 0; i < BLOCK_CNT; i += 7) 
+    {
+      size_t new_size = blocks[i].size * 3 / 2 + 1;
+      uint8_t *p = realloc (blocks[i].p, new_size);
+      if (p == NULL)
+        fail ("realloc of block %zu to %zu bytes failed", i, new_size);
+      blocks[i].p = p;
+      check_block (&blocks[i], i);
+      memset (p + blocks[i].size, i, new_size - blocks[i].size);
+      blocks[i].size = new_size;
+    }
+  for (i = 0; i < BLOCK_CNT; i++)
+    check_block (&blocks[i], i);
+  msg ("Grew some of them with realloc.");
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    free (blocks[i].p);
+  palloc_get_stats (0, &free_after, &largest);
+  if (free_after != free_before)
+    fail ("%zu free pages before, %zu after", free_before, free_after);
+  msg ("Freeing all of them returned every page.");
+
+  free (blocks);
+}
+
+/* Allocates a block of random size into B and fills it with
+   IDX. */
+static void
+alloc_block (struct block *b, size_t idx) 
+{
+  b->size = random_ulong () % MAX_SIZE + 1;
+  b->p = malloc (b->size);
+  if (b->p == NULL)
+    fail ("allocation of %zu bytes failed", b->size);
+  memset (b->p, idx, b->size);
+}
+
+/* Checks that block B is still filled with IDX. */
+static void
+check_block (struct block *b, size_t idx) 
+{
+  size_t i;
+
+  for (i = 0; i < b->size; i++)
+    if (b->p[i] != (uint8_t) idx)
+      fail ("block %zu (%zu bytes) was overwritten at byte %zu",
+            idx, b->size, i);
+}
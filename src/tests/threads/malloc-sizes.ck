@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-sizes) begin
+(malloc-sizes) Allocated 200 blocks of 1 to 5000 bytes.
+(malloc-sizes) Reallocated a random half of them.
+(malloc-sizes) Grew some of them with realloc.
+(malloc-sizes) Freeing all of them returned every page.
+(malloc-sizes) end
+EOF
+pass;
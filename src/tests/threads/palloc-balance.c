@@ -0,0 +1,56 @@
+/* Checks that the boundary between the kernel and user pools
+   moves under pressure.  First allocates more kernel pages than
+   the kernel pool has free, which only works if the kernel pool
+   takes pages from the idle user pool.  Then frees them and
+   reports a burst of evictions, after which the user pool should
+   take a chunk back. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+
+void
+test_palloc_balance (void) 
+{
+  size_t kernel_free, user_free, kernel_free0, user_free0, largest;
+  void **pages = NULL;
+  size_t page_cnt = 0;
+  int i;
+
+  palloc_get_stats (0, &kernel_free0, &largest);
+  palloc_get_stats (PAL_USER, &user_free0, &largest);
+
+  /* Chain the pages together through their first words, since
+     there is no kernel memory to spare for an array. */
+  while (page_cnt < kernel_free0 + 1) 
+    {
+      void **page = palloc_get_page (0);
+      if (page == NULL)
+        fail ("kernel pool ran out after %zu of %zu pages",
+              page_cnt, kernel_free0 + 1);
+      *page = pages;
+      pages = page;
+      page_cnt++;
+    }
+  palloc_get_stats (PAL_USER, &user_free, &largest);
+  if (user_free >= user_free0)
+    fail ("user pool did not shrink");
+  msg ("Kernel pool grew into the user pool.");
+
+  while (pages != NULL) 
+    {
+      void **next = *pages;
+      palloc_free_page (pages);
+      pages = next;
+    }
+
+  palloc_get_stats (0, &kernel_free0, &largest);
+  palloc_get_stats (PAL_USER, &user_free0, &largest);
+  for (i = 0; i < 100; i++)
+    palloc_note_eviction ();
+  palloc_get_stats (0, &kernel_free, &largest);
+  palloc_get_stats (PAL_USER, &user_free, &largest);
+  if (user_free <= user_free0 || kernel_free >= kernel_free0)
+    fail ("user pool did not grow after evictions");
+  msg ("User pool grew back after evictions.");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-balance) begin
+(palloc-balance) Kernel pool grew into the user pool.
+(palloc-balance) User pool grew back after evictions.
+(palloc-balance) end
+EOF
+pass;
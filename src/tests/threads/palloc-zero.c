@@ -0,0 +1,64 @@
+/* Checks that the idle thread keeps zeroed pages in stock for
+   PAL_ZERO requests.  The test sleeps to let the idle thread run,
+   then allocates zeroed pages, which should all come from the
+   stock and be all zeros.  It dirties and frees them, which
+   poisons them in debug builds, and does it again, so that the
+   stock has to be refilled. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define PAGE_CNT 8
+#define ROUND_CNT 2
+
+static void check_zero (const uint8_t *page, int idx);
+
+void
+test_palloc_zero (void) 
+{
+  uint8_t *pages[PAGE_CNT];
+  long long hits0, misses0, hits, misses;
+  int round, i;
+
+  for (round = 0; round < ROUND_CNT; round++) 
+    {
+      /* Let the idle thread run. */
+      timer_sleep (10);
+
+      palloc_get_zero_stats (0, &hits0, &misses0);
+      for (i = 0; i < PAGE_CNT; i++) 
+        {
+          pages[i] = palloc_get_page (PAL_ZERO);
+          if (pages[i] == NULL)
+            fail ("out of pages");
+          check_zero (pages[i], i);
+        }
+      palloc_get_zero_stats (0, &hits, &misses);
+      if (hits - hits0 != PAGE_CNT || misses != misses0)
+        fail ("%lld of %d zeroed pages came from stock, %lld did not",
+              hits - hits0, PAGE_CNT, misses - misses0);
+      msg ("Round %d: all %d zeroed pages came from stock.",
+           round, PAGE_CNT);
+
+      for (i = 0; i < PAGE_CNT; i++) 
+        {
+          memset (pages[i], 0x5a, PGSIZE);
+          palloc_free_page (pages[i]);
+        }
+    }
+}
+
+/* Fails unless PAGE, the IDX'th page allocated, is all zeros. */
+static void
+check_zero (const uint8_t *page, int idx) 
+{
+  size_t i;
+
+  for (i = 0; i < PGSIZE; i++)
+    if (page[i] != 0)
+      fail ("byte %zu of page %d is %#x, not 0", i, idx, page[i]);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-zero) begin
+(palloc-zero) Round 0: all 8 zeroed pages came from stock.
+(palloc-zero) Round 1: all 8 zeroed pages came from stock.
+(palloc-zero) end
+EOF
+pass;
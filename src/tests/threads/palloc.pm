@@ -0,0 +1,31 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+# Checks the output of one of the bench-palloc tests.  Timings and
+# fragmentation depend on the pool size, so they only need to be
+# present.
+sub check_bench_palloc {
+    our ($test);
+    my ($name) = $test =~ m%([^/]+)$%;
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+
+    fail "No timing results reported.\n" if !grep (/timing:/, @output);
+    fail "No fragmentation results reported.\n"
+      if !grep (/fragmentation:/, @output);
+    @output = grep (!/timing:|fragmentation:/, @output);
+
+    my (@expected) = ("($name) begin",
+		      "($name) Filling the user pool with runs of 1 to 8 pages.",
+		      "($name) No two runs overlapped.",
+		      "($name) Free pages coalesced back into the original blocks.",
+		      "($name) end");
+    my (@core) = grep (/^\(\Q$name\E\) /, @output);
+    fail "Output differs from expected:\n" . join ("\n", @core) . "\n"
+      if join ("\n", @core) ne join ("\n", @expected);
+    pass;
+}
+
+1;
@@ -0,0 +1,108 @@
+/* Wakes up hundreds of threads waiting on one semaphore, checking
+   that they come out highest priority first, and in the order
+   they went to sleep among threads of equal priority.
+
+   One of the waiters holds a lock that a high-priority thread
+   tries to acquire while everyone is asleep.  The donation has to
+   move that waiter to the front of the semaphore's waiters, so it
+   must be the first to wake up. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define WAITER_CNT 250
+
+struct waiter 
+  {
+    int id;                     /* Creation order. */
+    int priority;               /* Base priority. */
+  };
+
+static struct semaphore sema;
+static struct lock lock;
+static struct waiter waiters[WAITER_CNT];
+static struct waiter *wakeups[WAITER_CNT];   /* Order of waking. */
+static int wakeup_cnt;
+
+static thread_func waiter_thread;
+static thread_func holder_thread;
+static thread_func donor_thread;
+
+void
+test_priority_sema_many (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&sema, 0);
+  lock_init (&lock);
+  thread_set_priority (PRI_MIN);
+
+  msg ("Creating %d threads to wait on a semaphore.", WAITER_CNT);
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      struct waiter *w = &waiters[i];
+      char name[16];
+
+      w->id = i;
+      w->priority = PRI_MIN + 1 + (i * 7) % (PRI_DEFAULT - PRI_MIN - 1);
+      snprintf (name, sizeof name, "waiter %d", i);
+      thread_create (name, w->priority, i == WAITER_CNT / 2
+                     ? holder_thread : waiter_thread, w);
+    }
+  thread_create ("donor", PRI_DEFAULT + 1, donor_thread, NULL);
+
+  for (i = 0; i < WAITER_CNT; i++)
+    sema_up (&sema);
+
+  if (wakeup_cnt != WAITER_CNT)
+    fail ("%d of %d waiters woke up", wakeup_cnt, WAITER_CNT);
+  if (wakeups[0] != &waiters[WAITER_CNT / 2])
+    fail ("waiter %d woke up first instead of the lock holder",
+          wakeups[0]->id);
+  msg ("The waiter holding the lock woke up first.");
+
+  for (i = 2; i < WAITER_CNT; i++) 
+    {
+      struct waiter *a = wakeups[i - 1];
+      struct waiter *b = wakeups[i];
+
+      if (a->priority < b->priority
+          || (a->priority == b->priority && a->id > b->id))
+        fail ("waiter %d (priority %d) woke up before "
+              "waiter %d (priority %d)",
+              a->id, a->priority, b->id, b->priority);
+    }
+  msg ("The other waiters woke up in priority order.");
+}
+
+static void
+waiter_thread (void *w_) 
+{
+  struct waiter *w = w_;
+
+  sema_down (&sema);
+  wakeups[wakeup_cnt++] = w;
+}
+
+static void
+holder_thread (void *w_) 
+{
+  lock_acquire (&lock);
+  waiter_thread (w_);
+  lock_release (&lock);
+}
+
+static void
+donor_thread (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  msg ("donor: got the lock");
+  lock_release (&lock);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-sema-many) begin
+(priority-sema-many) Creating 250 threads to wait on a semaphore.
+(priority-sema-many) donor: got the lock
+(priority-sema-many) The waiter holding the lock woke up first.
+(priority-sema-many) The other waiters woke up in priority order.
+(priority-sema-many) end
+EOF
+pass;
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate) begin
+(rwlock-donate) This thread should have priority 41.  Actual priority: 41.
+(rwlock-donate) writer: got the lock
+(rwlock-donate) writer: done
+(rwlock-donate) medium: done
+(rwlock-donate) writer and medium must already have finished, in that order.
+(rwlock-donate) end
+EOF
+pass;
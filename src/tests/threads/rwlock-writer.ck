@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-writer) begin
+(rwlock-writer) This thread should have priority 32.  Actual priority: 32.
+(rwlock-writer) The reader must wait behind the waiting writer.
+(rwlock-writer) writer: got the lock
+(rwlock-writer) reader: got the lock
+(rwlock-writer) reader: done
+(rwlock-writer) writer: done
+(rwlock-writer) writer, then reader, must already have run.
+(rwlock-writer) end
+EOF
+pass;
@@ -0,0 +1,146 @@
+/* Tests for reader-writer locks.
+
+   rwlock-readers checks that several readers can hold an rwlock
+   at once.
+
+   rwlock-writer checks that a writer waiting for readers to
+   leave keeps out readers that arrive after it, even ones with
+   higher priority.
+
+   rwlock-donate checks that a writer waiting for readers to leave
+   donates its priority to them, so that a medium-priority thread
+   cannot hold it up by preempting the readers. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define READER_CNT 4
+
+struct readers_test
+  {
+    struct rwlock rw;
+    struct semaphore done;
+    int inside;                 /* Readers holding RW now. */
+    int max_inside;             /* Most readers holding RW at once. */
+  };
+
+static thread_func reader_sleep_func;
+static thread_func reader_func;
+static thread_func writer_func;
+static thread_func medium_func;
+
+void
+test_rwlock_readers (void) 
+{
+  struct readers_test test;
+  int i;
+
+  rwlock_init (&test.rw);
+  sema_init (&test.done, 0);
+  test.inside = test.max_inside = 0;
+
+  for (i = 0; i < READER_CNT; i++)
+    thread_create ("reader", PRI_DEFAULT, reader_sleep_func, &test);
+  for (i = 0; i < READER_CNT; i++)
+    sema_down (&test.done);
+
+  msg ("%d readers held the lock at once.", test.max_inside);
+}
+
+/* Holds the rwlock for reading for a while. */
+static void
+reader_sleep_func (void *test_) 
+{
+  struct readers_test *test = test_;
+  enum intr_level old_level;
+
+  rw_read_acquire (&test->rw);
+  old_level = intr_disable ();
+  if (++test->inside > test->max_inside)
+    test->max_inside = test->inside;
+  intr_set_level (old_level);
+
+  timer_sleep (10);
+
+  old_level = intr_disable ();
+  test->inside--;
+  intr_set_level (old_level);
+  rw_read_release (&test->rw);
+  sema_up (&test->done);
+}
+
+void
+test_rwlock_writer (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rw_read_acquire (&rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  thread_create ("reader", PRI_DEFAULT + 2, reader_func, &rw);
+  msg ("The reader must wait behind the waiting writer.");
+  rw_read_release (&rw);
+  msg ("writer, then reader, must already have run.");
+}
+
+void
+test_rwlock_donate (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rw_read_acquire (&rw);
+  thread_create ("writer", PRI_DEFAULT + 10, writer_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 10, thread_get_priority ());
+  thread_create ("medium", PRI_DEFAULT + 5, medium_func, NULL);
+  rw_read_release (&rw);
+  msg ("writer and medium must already have finished, in that order.");
+}
+
+static void
+reader_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_read_acquire (rw);
+  msg ("reader: got the lock");
+  rw_read_release (rw);
+  msg ("reader: done");
+}
+
+static void
+writer_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rw_write_acquire (rw);
+  msg ("writer: got the lock");
+  rw_write_release (rw);
+  msg ("writer: done");
+}
+
+static void
+medium_func (void *aux UNUSED) 
+{
+  msg ("medium: done");
+}
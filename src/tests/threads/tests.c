@@ -13,10 +13,13 @@ static const struct test tests[] =
   {
     {"alarm-single", test_alarm_single},
     {"alarm-multiple", test_alarm_multiple},
+    {"alarm-tickless", test_alarm_tickless},
+    {"alarm-cascade", test_alarm_cascade},
     {"alarm-simultaneous", test_alarm_simultaneous},
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-thousand", test_alarm_thousand},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -38,6 +41,27 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"fair-20", test_fair_20},
+    {"fair-nice-2", test_fair_nice_2},
+    {"edf-load", test_edf_load},
+    {"edf-admission", test_edf_admission},
+    {"edf-requeue", test_edf_requeue},
+    {"bench-switch", test_bench_switch},
+    {"rwlock-readers", test_rwlock_readers},
+    {"rwlock-writer", test_rwlock_writer},
+    {"rwlock-donate", test_rwlock_donate},
+    {"bench-rwlock", test_bench_rwlock},
+    {"lock-stats", test_lock_stats},
+    {"priority-sema-many", test_priority_sema_many},
+    {"intr-defer", test_intr_defer},
+    {"bench-palloc", test_bench_palloc},
+    {"bench-palloc-64", test_bench_palloc},
+    {"bench-palloc-256", test_bench_palloc},
+    {"kmem-cache", test_kmem_cache},
+    {"malloc-sizes", test_malloc_sizes},
+    {"palloc-zero", test_palloc_zero},
+    {"palloc-balance", test_palloc_balance},
+    {"latency-hist", test_latency_hist},
   };
 
 static const char *test_name;
@@ -7,10 +7,13 @@ typedef void test_func (void);
 
 extern test_func test_alarm_single;
 extern test_func test_alarm_multiple;
+extern test_func test_alarm_tickless;
+extern test_func test_alarm_cascade;
 extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_thousand;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -32,6 +35,25 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_fair_20;
+extern test_func test_fair_nice_2;
+extern test_func test_edf_load;
+extern test_func test_edf_admission;
+extern test_func test_edf_requeue;
+extern test_func test_bench_switch;
+extern test_func test_rwlock_readers;
+extern test_func test_rwlock_writer;
+extern test_func test_rwlock_donate;
+extern test_func test_bench_rwlock;
+extern test_func test_lock_stats;
+extern test_func test_priority_sema_many;
+extern test_func test_intr_defer;
+extern test_func test_bench_palloc;
+extern test_func test_kmem_cache;
+extern test_func test_malloc_sizes;
+extern test_func test_palloc_zero;
+extern test_func test_palloc_balance;
+extern test_func test_latency_hist;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
@@ -0,0 +1,41 @@
+/* Runs child-big, which gives itself 256 resident pages, several
+   times in a row, and reports how many timer ticks it took in
+   all.  Most of that is spent creating and destroying the
+   children's address spaces, so it shows how fast exiting
+   processes give their frames back.
+
+   The tick count depends on the machine, so it is reported on a
+   "timing:" line. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 8
+
+static long long
+total_ticks (const struct rusage *r) 
+{
+  return r->run_ticks + r->ready_ticks + r->blocked_ticks;
+}
+
+void
+test_main (void)
+{
+  struct rusage before, after;
+  int i;
+
+  CHECK (getrusage (&before) == 0, "getrusage before children");
+  for (i = 0; i < CHILD_CNT; i++) 
+    {
+      pid_t child = exec ("child-big");
+      if (child == -1)
+        fail ("exec \"child-big\" failed");
+      if (wait (child) != 0x42)
+        fail ("child %d returned wrong value", i);
+    }
+  CHECK (getrusage (&after) == 0, "getrusage after children");
+  msg ("ran %d children", CHILD_CNT);
+  msg ("timing: %lld ticks for %d children",
+       total_ticks (&after) - total_ticks (&before), CHILD_CNT);
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Tick counts differ from machine to machine, so they only need to
+# be present.
+fail "No tick count reported.\n" if !grep (/timing:/, @output);
+@output = grep (!/timing:/, @output);
+
+my (@expected) = ("(bench-exit) begin",
+		  "(bench-exit) getrusage before children",
+		  "(bench-exit) getrusage after children",
+		  "(bench-exit) ran 8 children",
+		  "(bench-exit) end");
+my (@core) = grep (/^\(bench-exit\) /, @output);
+fail "Output differs from expected:\n" . join ("\n", @core) . "\n"
+  if join ("\n", @core) ne join ("\n", @expected);
+pass;
@@ -0,0 +1,41 @@
+/* Runs 4 child-fault processes at once, which together need more
+   memory than there is, and reports how many timer ticks they
+   took in all.  Each child also reports its own page faults, so
+   the aggregate fault throughput can be worked out.  Faults in
+   different processes only overlap if evicting a page does not
+   hold up every other fault for the length of its disk write.
+
+   The counts depend on the machine, so they are reported on
+   "timing:" lines. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 4
+
+static long long
+total_ticks (const struct rusage *r) 
+{
+  return r->run_ticks + r->ready_ticks + r->blocked_ticks;
+}
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  struct rusage before, after;
+  int i;
+
+  CHECK (getrusage (&before) == 0, "getrusage before children");
+  for (i = 0; i < CHILD_CNT; i++) 
+    if ((children[i] = exec ("child-fault")) == -1)
+      fail ("exec \"child-fault\" failed");
+  for (i = 0; i < CHILD_CNT; i++) 
+    if (wait (children[i]) != 0x42)
+      fail ("child %d returned wrong value", i);
+  CHECK (getrusage (&after) == 0, "getrusage after children");
+  msg ("ran %d children", CHILD_CNT);
+  msg ("timing: %lld ticks for %d children",
+       total_ticks (&after) - total_ticks (&before), CHILD_CNT);
+}
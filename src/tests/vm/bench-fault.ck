@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Tick and fault counts differ from machine to machine, so they
+# only need to be present.
+fail "No tick count reported.\n" if !grep (/timing: .* ticks/, @output);
+fail "No page fault counts reported.\n"
+  if !grep (/timing: .* page faults/, @output);
+@output = grep (!/timing:/, @output);
+
+my (@expected) = ("(bench-fault) begin",
+		  "(bench-fault) getrusage before children",
+		  "(bench-fault) getrusage after children",
+		  "(bench-fault) ran 4 children",
+		  "(bench-fault) end");
+my (@core) = grep (/^\(bench-fault\) /, @output);
+fail "Output differs from expected:\n" . join ("\n", @core) . "\n"
+  if join ("\n", @core) ne join ("\n", @expected);
+pass;
@@ -0,0 +1,46 @@
+/* Writes every page of a 2 MB array, more than fits in memory,
+   several times over in order, so that nearly every page is
+   swapped out and back in on every pass, and reports how many
+   timer ticks the passes took.  Checks at the end that no page
+   lost its contents on the way.
+
+   The tick count depends on the machine, so it is reported on a
+   "timing:" line. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define SIZE (2 * 1024 * 1024)
+#define PASS_CNT 4
+
+static char buf[SIZE];
+
+static long long
+total_ticks (const struct rusage *r) 
+{
+  return r->run_ticks + r->ready_ticks + r->blocked_ticks;
+}
+
+void
+test_main (void)
+{
+  struct rusage before, after;
+  size_t i;
+  int pass;
+
+  CHECK (getrusage (&before) == 0, "getrusage before passes");
+  for (pass = 0; pass < PASS_CNT; pass++)
+    for (i = 0; i < SIZE; i += PAGE_SIZE)
+      buf[i] += i / PAGE_SIZE + 1;
+  CHECK (getrusage (&after) == 0, "getrusage after passes");
+
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    if (buf[i] != (char) (PASS_CNT * (i / PAGE_SIZE + 1)))
+      fail ("page %zu has wrong contents", i / PAGE_SIZE);
+  msg ("checked %d pages", SIZE / PAGE_SIZE);
+  msg ("timing: %lld ticks, %d page faults for %d passes",
+       total_ticks (&after) - total_ticks (&before),
+       after.page_faults - before.page_faults, PASS_CNT);
+}
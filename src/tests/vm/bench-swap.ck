@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# Tick counts differ from machine to machine, so they only need to
+# be present.
+fail "No tick count reported.\n" if !grep (/timing:/, @output);
+@output = grep (!/timing:/, @output);
+
+my (@expected) = ("(bench-swap) begin",
+		  "(bench-swap) getrusage before passes",
+		  "(bench-swap) getrusage after passes",
+		  "(bench-swap) checked 512 pages",
+		  "(bench-swap) end");
+my (@core) = grep (/^\(bench-swap\) /, @output);
+fail "Output differs from expected:\n" . join ("\n", @core) . "\n"
+  if join ("\n", @core) ne join ("\n", @expected);
+pass;
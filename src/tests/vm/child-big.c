@@ -0,0 +1,22 @@
+/* Child process of bench-exit.
+   Touches every page of a 1 MB array, so that it has a large
+   number of resident pages, and exits without freeing them. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+const char *test_name = "child-big";
+
+#define PAGE_SIZE 4096
+#define SIZE (1024 * 1024)
+static char buf[SIZE];
+
+int
+main (void)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    buf[i] = 1;
+  return 0x42;
+}
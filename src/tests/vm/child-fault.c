@@ -0,0 +1,35 @@
+/* Child process of bench-fault.
+   Writes every page of a 1 MB array several times over, so that
+   with other copies running it keeps faulting pages in and out,
+   and reports how many page faults it took. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+const char *test_name = "child-fault";
+
+#define PAGE_SIZE 4096
+#define SIZE (1024 * 1024)
+#define PASS_CNT 4
+static char buf[SIZE];
+
+int
+main (void)
+{
+  struct rusage r;
+  size_t i;
+  int pass;
+
+  for (pass = 0; pass < PASS_CNT; pass++)
+    for (i = 0; i < SIZE; i += PAGE_SIZE)
+      buf[i] = pass;
+
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    if (buf[i] != PASS_CNT - 1)
+      fail ("byte %zu is %d, not %d", i, buf[i], PASS_CNT - 1);
+
+  if (getrusage (&r) == 0)
+    msg ("timing: %d page faults", r.page_faults);
+  return 0x42;
+}
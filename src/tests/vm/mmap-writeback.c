@@ -0,0 +1,56 @@
+/* Writes a pattern to a 256 kB file through a mapping, then
+   touches a 2 MB array so that the mapped pages are pushed out
+   of memory, either by eviction or ahead of it by the page
+   cleaner.  Unmaps the file and reads it back with the read
+   system call to verify that every page reached the disk. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define MAP_SIZE (256 * 1024)
+#define BIG_SIZE (2 * 1024 * 1024)
+
+static char *map_buf = (char *) 0x10000000;
+static char big[BIG_SIZE];
+
+static char
+pattern (size_t ofs) 
+{
+  return ofs / PAGE_SIZE + ofs * 7;
+}
+
+void
+test_main (void)
+{
+  char block[1024];
+  size_t i, j;
+  int handle;
+  mapid_t map;
+
+  CHECK (create ("buffer", MAP_SIZE), "create \"buffer\"");
+  CHECK ((handle = open ("buffer")) > 1, "open \"buffer\"");
+  CHECK ((map = mmap (handle, map_buf)) != MAP_FAILED, "mmap \"buffer\"");
+
+  for (i = 0; i < MAP_SIZE; i++)
+    map_buf[i] = pattern (i);
+  msg ("wrote mapping");
+
+  for (i = 0; i < BIG_SIZE; i += PAGE_SIZE)
+    big[i] = i / PAGE_SIZE;
+  msg ("touched big array");
+
+  munmap (map);
+  for (i = 0; i < MAP_SIZE; i += sizeof block) 
+    {
+      if (read (handle, block, sizeof block) != sizeof block)
+        fail ("read at offset %zu failed", i);
+      for (j = 0; j < sizeof block; j++)
+        if (block[j] != pattern (i + j))
+          fail ("byte %zu differs from what was written", i + j);
+    }
+  msg ("verified file");
+  close (handle);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-writeback) begin
+(mmap-writeback) create "buffer"
+(mmap-writeback) open "buffer"
+(mmap-writeback) mmap "buffer"
+(mmap-writeback) wrote mapping
+(mmap-writeback) touched big array
+(mmap-writeback) verified file
+(mmap-writeback) end
+EOF
+pass;
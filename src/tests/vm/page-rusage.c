@@ -0,0 +1,32 @@
+/* Checks that getrusage() counts the page faults taken in
+   touching each page of a large zero-filled array for the first
+   time, and that the run time it reports does not go
+   backward. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 64
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct rusage before, after;
+  size_t i;
+
+  CHECK (getrusage (&before) == 0, "getrusage before touching pages");
+  for (i = 0; i < sizeof buf; i += PAGE_SIZE)
+    buf[i] = 1;
+  CHECK (getrusage (&after) == 0, "getrusage after touching pages");
+
+  if (after.page_faults - before.page_faults < PAGE_CNT)
+    fail ("%d page faults counted, expected at least %d",
+          after.page_faults - before.page_faults, PAGE_CNT);
+  msg ("page faults counted");
+
+  if (after.run_ticks < before.run_ticks)
+    fail ("run ticks went backward");
+}
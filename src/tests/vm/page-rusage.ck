@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-rusage) begin
+(page-rusage) getrusage before touching pages
+(page-rusage) getrusage after touching pages
+(page-rusage) page faults counted
+(page-rusage) end
+EOF
+pass;
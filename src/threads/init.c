@@ -19,7 +19,9 @@
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/pte.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -35,6 +37,10 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/swap.h"
+#endif
 
 /* Amount of physical memory, in 4 kB pages. */
 size_t ram_pages;
@@ -53,6 +59,9 @@ bool power_off_when_done;
 /* -r: Reboot after kernel tasks complete? */
 static bool reboot_when_done;
 
+/* -latreset: Clear the wakeup latency histograms once booted? */
+static bool reset_latency;
+
 static void ram_init (void);
 static void paging_init (void);
 
@@ -91,7 +100,10 @@ main (void)
   palloc_init ();
   malloc_init ();
   paging_init ();
+#ifdef VM
   frame_table_init ();
+  page_init ();
+#endif
   /* Segmentation. */
 #ifdef USERPROG
   tss_init ();
@@ -118,7 +130,12 @@ main (void)
   disk_init ();
   filesys_init (format_filesys);
 #endif
+#ifdef VM
   swap_init ();
+  frame_cleaner_start ();
+#endif
+  if (reset_latency)
+    thread_reset_latency ();
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -253,14 +270,29 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
-#ifdef USERPROG
+      else if (!strcmp (name, "-fair"))
+        thread_fair = true;
+      else if (!strcmp (name, "-tickless"))
+        timer_tickless = true;
+      else if (!strcmp (name, "-lockstat"))
+        lock_stat_top = value != NULL ? atoi (value) : 10;
+      else if (!strcmp (name, "-latreset"))
+        reset_latency = true;
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#ifdef VM
+      else if (!strcmp (name, "-clean-ticks"))
+        frame_clean_ticks = atoi (value);
+      else if (!strcmp (name, "-clean-batch"))
+        frame_clean_batch = atoi (value);
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
     }
 
+  if (thread_mlfqs && thread_fair)
+    PANIC ("-mlfqs and -fair cannot be used together");
+
   /* Initialize the random number generator based on the system
      time.  This has no effect if an "-rs" option was specified.
 
@@ -375,8 +407,14 @@ usage (void)
           "  -f                 Format file system disk during startup.\n"
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
-#ifdef USERPROG
+          "  -fair              Use fair-share scheduler.\n"
+          "  -tickless          Stop the periodic timer tick while idle.\n"
+          "  -lockstat[=N]      Print the N most contended locks (default 10).\n"
+          "  -latreset          Leave boot-time wakeups out of latency stats.\n"
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#ifdef VM
+          "  -clean-ticks=N     Run the page cleaner every N ticks (0=off).\n"
+          "  -clean-batch=N     Write back at most N pages per run (0=off).\n"
 #endif
           );
   power_off ();
@@ -428,7 +466,9 @@ power_off (void)
 #ifdef FILESYS
   filesys_done ();
 #endif
-swap_end ();
+#ifdef VM
+  swap_end ();
+#endif
   print_stats ();
 
   printf ("Powering off...\n");
@@ -447,12 +487,22 @@ print_stats (void)
 {
   timer_print_stats ();
   thread_print_stats ();
+  thread_print_usage ();
+  intr_print_stats ();
 #ifdef FILESYS
   disk_print_stats ();
 #endif
+  lock_print_stats ();
+  palloc_print_stats ();
+  malloc_print_stats ();
+  kmem_print_stats ();
   console_print_stats ();
   kbd_print_stats ();
 #ifdef USERPROG
   exception_print_stats ();
 #endif
+#ifdef VM
+  frame_print_stats ();
+  swap_print_stats ();
+#endif
 }
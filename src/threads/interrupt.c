@@ -6,6 +6,8 @@
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
+#include "threads/spinlock.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
@@ -43,6 +45,48 @@ static const char *intr_names[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Deferred work queued with intr_defer().  When an external
+   interrupt's handler is done, the PIC has been acknowledged and
+   interrupts are turned back on, and then the queue is drained
+   before the interrupted thread resumes or yields.  IN_SOFTIRQ is
+   set while this happens.  An external interrupt that arrives in
+   the meantime leaves its own deferred work and any yield to the
+   drain that is already in progress, so deferred work, like an
+   interrupt handler, never runs in two threads at once and never
+   gives up the CPU until the queue is empty. */
+static struct list softirq_queue;
+static bool in_softirq;         /* Draining softirq_queue? */
+
+/* Work queued with intr_defer_to_worker() and the threads that
+   run it.  The threads are only created once something needs
+   them, so a kernel that never defers work to a thread does not
+   carry them. */
+#define WORKER_CNT 2
+static struct list worker_queue;
+static struct semaphore worker_sema;    /* Upped per queued item. */
+static bool workers_started;
+
+/* Protects softirq_queue, worker_queue, and the `pending' member
+   of every work item. */
+static struct spinlock defer_lock;
+
+/* Time spent in each external interrupt's handler, which runs
+   with interrupts off, and in deferred work, which does not.
+   Measured with thread_clock(). */
+struct intr_stat 
+  {
+    unsigned cnt;               /* Times run. */
+    uint64_t total;             /* Total time. */
+    uint64_t max;               /* Longest run. */
+  };
+static struct intr_stat external_stats[16];
+static struct intr_stat softirq_stats;
+static struct intr_stat worker_stats;
+
+static void intr_stat_add (struct intr_stat *, uint64_t start);
+static void softirq_drain (void);
+static thread_func worker_thread;
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -83,7 +127,11 @@ enum intr_level
 intr_enable (void) 
 {
   enum intr_level old_level = intr_get_level ();
-  ASSERT (!intr_context ());
+
+  /* Only a hardware handler itself must keep interrupts off.
+     Deferred work runs in interrupt context with them on, and may
+     restore that level after turning them off, as sema_up() does. */
+  ASSERT (!in_external_intr);
 
   /* Enable interrupts by setting the interrupt flag.
 
@@ -150,6 +198,12 @@ intr_init (void)
   intr_names[17] = "#AC Alignment Check Exception";
   intr_names[18] = "#MC Machine-Check Exception";
   intr_names[19] = "#XF SIMD Floating-Point Exception";
+
+  /* Initialize deferred work queues. */
+  list_init (&softirq_queue);
+  list_init (&worker_queue);
+  spinlock_init (&defer_lock);
+  sema_init (&worker_sema, 0);
 }
 
 /* Registers interrupt VEC_NO to invoke HANDLER with descriptor
@@ -201,12 +255,12 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
   register_handler (vec_no, dpl, level, handler, name);
 }
 
-/* Returns true during processing of an external interrupt
-   and false at all other times. */
+/* Returns true during processing of an external interrupt,
+   including its deferred work, and false at all other times. */
 bool
 intr_context (void) 
 {
-  return in_external_intr;
+  return in_external_intr || in_softirq;
 }
 
 /* During processing of an external interrupt, directs the
@@ -346,14 +400,24 @@ intr_handler (struct intr_frame *frame)
      We only handle one at a time (so interrupts must be off)
      and they need to be acknowledged on the PIC (see below).
      An external interrupt handler cannot sleep. */
+  uint64_t start = 0;
+
   external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
   if (external) 
     {
       ASSERT (intr_get_level () == INTR_OFF);
-      ASSERT (!intr_context ());
+      ASSERT (!in_external_intr);
 
       in_external_intr = true;
-      yield_on_return = false;
+      if (!in_softirq)
+        yield_on_return = false;
+      start = thread_clock ();
+
+      /* Bring timer_ticks() up to date before this handler can
+         wake a thread after a tickless stretch.  The timer
+         interrupt (IRQ 0) does so itself. */
+      if (frame->vec_no != 0x20)
+        timer_catch_up ();
     }
 
   /* Invoke the interrupt's handler. */
@@ -382,9 +446,195 @@ intr_handler (struct intr_frame *frame)
 
       in_external_intr = false;
       pic_end_of_interrupt (frame->vec_no); 
+      intr_stat_add (&external_stats[frame->vec_no - 0x20], start);
+
+      if (!in_softirq) 
+        {
+          softirq_drain ();
+          if (yield_on_return) 
+            thread_yield (); 
+        }
+    }
+}
+
+/* Adds the time since START to STAT. */
+static void
+intr_stat_add (struct intr_stat *stat, uint64_t start) 
+{
+  uint64_t elapsed = thread_clock () - start;
+
+  stat->cnt++;
+  stat->total += elapsed;
+  if (elapsed > stat->max)
+    stat->max = elapsed;
+}
+
+/* Prints how long external interrupt handlers kept interrupts
+   off, and how much work they deferred. */
+void
+intr_print_stats (void) 
+{
+  const char *unit = thread_clock_unit ();
+  int irq;
+
+  for (irq = 0; irq < 16; irq++) 
+    {
+      struct intr_stat *s = &external_stats[irq];
+      if (s->cnt > 0)
+        printf ("Interrupt: %#04x (%s): %u handled, "
+                "%llu avg, %llu max %s with interrupts off\n",
+                irq + 0x20, intr_names[irq + 0x20], s->cnt,
+                s->total / s->cnt, s->max, unit);
+    }
+  printf ("Interrupt: %u deferred items, %llu max %s; "
+          "%u worker items, %llu max %s\n",
+          softirq_stats.cnt, softirq_stats.max, unit,
+          worker_stats.cnt, worker_stats.max, unit);
+}
+
+/* Initializes deferred work item WORK to call FUNC with AUX. */
+void
+intr_work_init (struct intr_work *work, intr_work_func *func, void *aux) 
+{
+  ASSERT (work != NULL);
+  ASSERT (func != NULL);
+
+  work->func = func;
+  work->aux = aux;
+  work->pending = false;
+}
+
+/* Queues WORK to run before the current external interrupt
+   returns, with interrupts on.  Does nothing if WORK is already
+   queued.  May only be called during processing of an external
+   interrupt. */
+void
+intr_defer (struct intr_work *work) 
+{
+  ASSERT (intr_context ());
+
+  spinlock_acquire (&defer_lock);
+  if (!work->pending) 
+    {
+      work->pending = true;
+      list_push_back (&softirq_queue, &work->elem);
+    }
+  spinlock_release (&defer_lock);
+}
 
-      if (yield_on_return) 
-        thread_yield (); 
+/* Queues WORK to run in a kernel worker thread.  Does nothing if
+   WORK is already queued.  The first call starts the worker
+   threads.  May be called from an interrupt handler, but only
+   once intr_workers_start() has been called, since threads cannot
+   be created in interrupt context. */
+void
+intr_defer_to_worker (struct intr_work *work) 
+{
+  bool queued = false;
+
+  ASSERT (work != NULL);
+
+  if (!intr_context ())
+    intr_workers_start ();
+  ASSERT (workers_started);
+
+  spinlock_acquire (&defer_lock);
+  if (!work->pending) 
+    {
+      work->pending = true;
+      list_push_back (&worker_queue, &work->elem);
+      queued = true;
+    }
+  spinlock_release (&defer_lock);
+
+  if (queued)
+    sema_up (&worker_sema);
+}
+
+/* Starts the worker threads behind intr_defer_to_worker(), unless
+   they are already running.  Must be called after thread_start(),
+   and not from an interrupt handler. */
+void
+intr_workers_start (void) 
+{
+  enum intr_level old_level;
+  bool started;
+  int i;
+
+  ASSERT (!intr_context ());
+
+  old_level = intr_disable ();
+  started = workers_started;
+  workers_started = true;
+  intr_set_level (old_level);
+  if (started)
+    return;
+
+  for (i = 0; i < WORKER_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "intr-worker %d", i);
+      thread_create (name, PRI_MAX, worker_thread, NULL);
+    }
+}
+
+/* Runs the work in softirq_queue, with interrupts on.  Called
+   with interrupts off at the end of an external interrupt, and
+   returns with them off. */
+static void
+softirq_drain (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  in_softirq = true;
+  for (;;) 
+    {
+      struct intr_work *work;
+      uint64_t start;
+
+      spinlock_acquire (&defer_lock);
+      if (list_empty (&softirq_queue)) 
+        {
+          spinlock_release (&defer_lock);
+          break;
+        }
+      work = list_entry (list_pop_front (&softirq_queue),
+                         struct intr_work, elem);
+      work->pending = false;
+      spinlock_release (&defer_lock);
+
+      asm volatile ("sti");
+      start = thread_clock ();
+      work->func (work->aux);
+      intr_stat_add (&softirq_stats, start);
+      asm volatile ("cli" : : : "memory");
+    }
+  in_softirq = false;
+}
+
+/* Worker thread: runs work queued with intr_defer_to_worker(),
+   forever. */
+static void
+worker_thread (void *aux UNUSED) 
+{
+  for (;;) 
+    {
+      enum intr_level old_level;
+      struct intr_work *work;
+      uint64_t start;
+
+      sema_down (&worker_sema);
+      spinlock_acquire (&defer_lock);
+      work = list_entry (list_pop_front (&worker_queue),
+                         struct intr_work, elem);
+      work->pending = false;
+      spinlock_release (&defer_lock);
+
+      start = thread_clock ();
+      work->func (work->aux);
+      old_level = intr_disable ();
+      intr_stat_add (&worker_stats, start);
+      intr_set_level (old_level);
     }
 }
 
@@ -1,6 +1,7 @@
 #ifndef THREADS_INTERRUPT_H
 #define THREADS_INTERRUPT_H
 
+#include <list.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -66,5 +67,29 @@ void intr_yield_on_return (void);
 
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
+void intr_print_stats (void);
+
+/* Deferred work.
+
+   An interrupt handler that has more to do than it needs to do
+   with interrupts off can queue the rest as a work item instead.
+   intr_defer() runs the item just before the interrupt returns,
+   in interrupt context but with interrupts turned back on, so it
+   must not sleep either.  intr_defer_to_worker() hands the item
+   to a kernel worker thread, where it may sleep. */
+typedef void intr_work_func (void *aux);
+
+struct intr_work 
+  {
+    struct list_elem elem;      /* Queue element. */
+    intr_work_func *func;       /* Function to run. */
+    void *aux;                  /* Its argument. */
+    bool pending;               /* Queued but not yet run? */
+  };
+
+void intr_work_init (struct intr_work *, intr_work_func *, void *aux);
+void intr_defer (struct intr_work *);
+void intr_defer_to_worker (struct intr_work *);
+void intr_workers_start (void);
 
 #endif /* threads/interrupt.h */
@@ -1,46 +1,76 @@
 #include "threads/malloc.h"
 #include <debug.h>
+#include <inttypes.h>
 #include <list.h>
 #include <round.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
 
-   The size of each request, in bytes, is rounded up to a power
-   of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
-
-   Otherwise, a new page of memory, called an "arena", is
-   obtained from the page allocator (if none is available,
-   malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
+   The size of each request, in bytes, is rounded up to the
+   nearest "size class" and assigned to the "descriptor" that
+   manages blocks of that size.  Size classes are spaced so that
+   rounding wastes at most about 12.5% of a block: each power of
+   2 from 64 bytes up is divided into 8 equal steps (64, 72, 80,
+   ..., 120, 128, 144, ...), and below that the classes go up in
+   8-byte steps from 16.  A table indexed by the request size
+   divided by 8 gives the descriptor directly.  The descriptor
+   keeps a list of free blocks.  If the free list is nonempty,
+   one of its blocks is used to satisfy the request.
+
+   Otherwise, a new run of pages, called an "arena", is obtained
+   from the page allocator (if none is available, malloc()
+   returns a null pointer).  Arenas for small classes are a
+   single page.  For larger classes, a page holds few blocks and
+   leaves a big leftover, so their arenas span as many pages
+   (a power of 2) as it takes to waste less than 1/8 of the
+   arena.  The new arena is divided into blocks, all of which are
+   added to the descriptor's free list.  Then we return one of
+   the new blocks.
 
    When we free a block, we add it to its descriptor's free list.
    But if the arena that the block was in now has no in-use
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
-   We can't handle blocks bigger than 2 kB using this scheme,
-   because they're too big to fit in a single page with a
-   descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   Blocks in a multi-page arena may lie in any of its pages, so
+   we can't find a block's arena by rounding its address down.
+   Instead, a table with an entry for each page of physical
+   memory records the arena that each page belongs to.
+
+   Requests bigger than the largest size class are handled by
+   allocating contiguous pages with the page allocator and
+   sticking the allocation size at the beginning of the allocated
+   block's arena header. */
+
+/* Request statistics, for malloc_print_stats(). */
+struct malloc_stats
+  {
+    uint64_t cnt;               /* Number of requests. */
+    uint64_t req_bytes;         /* Bytes requested. */
+    uint64_t alloc_bytes;       /* Bytes handed out. */
+    uint64_t pow2_bytes;        /* Bytes power-of-2 classes would give. */
+  };
 
 /* Descriptor. */
 struct desc
   {
     size_t block_size;          /* Size of each element in bytes. */
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
+    size_t arena_pages;         /* Number of pages in an arena. */
     struct list free_list;      /* List of free blocks. */
     struct lock lock;           /* Lock. */
+    char name[16];              /* Lock name, e.g. "malloc 16". */
+    size_t arena_cnt;           /* Number of arenas. */
+    size_t in_use;              /* Number of blocks in use. */
+    struct malloc_stats stats;  /* Request statistics. */
   };
 
 /* Magic number for detecting arena corruption. */
@@ -60,10 +90,33 @@ struct block
     struct list_elem free_elem; /* Free list element. */
   };
 
+/* Size classes.  Every class is a multiple of CLASS_ALIGN bytes,
+   and MAX_CLASS is the largest one. */
+#define CLASS_ALIGN 8
+#define MAX_CLASS 3840
+
+/* Largest number of pages in an arena. */
+#define MAX_ARENA_PAGES 8
+
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[54];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Maps a request of SIZE bytes, for 0 < SIZE <= MAX_CLASS, to the
+   descriptor at descs[size_to_desc[DIV_ROUND_UP (SIZE, CLASS_ALIGN)]]. */
+static uint8_t size_to_desc[MAX_CLASS / CLASS_ALIGN + 1];
+
+/* Maps the physical page number of each page in an arena to the
+   arena. */
+static struct arena **page_arenas;
+
+/* Statistics for big blocks. */
+static struct malloc_stats big_stats;
+
+static void init_desc (size_t block_size);
+static void count_request (struct malloc_stats *, size_t req, size_t alloc);
+static void set_page_arenas (struct arena *, size_t page_cnt,
+                             struct arena *);
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
 
@@ -71,17 +124,67 @@ static struct block *arena_to_block (struct arena *, size_t idx);
 void
 malloc_init (void) 
 {
-  size_t block_size;
+  size_t block_size, step, size;
 
-  for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2)
+  /* Create the size classes. */
+  for (block_size = 16; block_size <= MAX_CLASS; block_size += step) 
     {
-      struct desc *d = &descs[desc_cnt++];
-      ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
-      d->block_size = block_size;
-      d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-      list_init (&d->free_list);
-      lock_init (&d->lock);
+      size_t pow2;
+
+      for (pow2 = 64; pow2 * 2 <= block_size; pow2 *= 2)
+        continue;
+      step = block_size < 64 ? CLASS_ALIGN : pow2 / 8;
+      init_desc (block_size);
     }
+
+  /* Fill in the size lookup table. */
+  for (size = 0; size <= MAX_CLASS / CLASS_ALIGN; size++) 
+    {
+      size_t i = 0;
+      while (descs[i].block_size < size * CLASS_ALIGN)
+        i++;
+      size_to_desc[size] = i;
+    }
+
+  page_arenas = palloc_get_multiple (PAL_ASSERT | PAL_ZERO,
+                                     DIV_ROUND_UP (ram_pages
+                                                   * sizeof *page_arenas,
+                                                   PGSIZE));
+}
+
+/* Initializes the next descriptor for BLOCK_SIZE-byte blocks,
+   picking the smallest arena that wastes less than 1/8 of its
+   pages, or the least wasteful if none does. */
+static void
+init_desc (size_t block_size) 
+{
+  struct desc *d = &descs[desc_cnt++];
+  size_t page_cnt, best_waste = SIZE_MAX;
+
+  ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
+  d->block_size = block_size;
+  for (page_cnt = 1; page_cnt <= MAX_ARENA_PAGES; page_cnt *= 2) 
+    {
+      size_t arena_size = page_cnt * PGSIZE;
+      size_t blocks = (arena_size - sizeof (struct arena)) / block_size;
+      size_t waste = arena_size - blocks * block_size;
+
+      /* Compare waste as a fraction of the arena, in 1/1024ths. */
+      waste = waste * 1024 / arena_size;
+      if (blocks > 0 && waste < best_waste) 
+        {
+          d->arena_pages = page_cnt;
+          d->blocks_per_arena = blocks;
+          best_waste = waste;
+          if (waste < 1024 / 8)
+            break;
+        }
+    }
+  list_init (&d->free_list);
+  snprintf (d->name, sizeof d->name, "malloc %zu", block_size);
+  lock_init_named (&d->lock, d->name);
+  d->arena_cnt = 0;
+  d->in_use = 0;
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -97,16 +200,13 @@ malloc (size_t size)
   if (size == 0)
     return NULL;
 
-  /* Find the smallest descriptor that satisfies a SIZE-byte
-     request. */
-  for (d = descs; d < descs + desc_cnt; d++)
-    if (d->block_size >= size)
-      break;
-  if (d == descs + desc_cnt) 
+  if (size > MAX_CLASS) 
     {
       /* SIZE is too big for any descriptor.
          Allocate enough pages to hold SIZE plus an arena. */
       size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
+      enum intr_level old_level;
+
       a = palloc_get_multiple (0, page_cnt);
       if (a == NULL)
         return NULL;
@@ -116,9 +216,19 @@ malloc (size_t size)
       a->magic = ARENA_MAGIC;
       a->desc = NULL;
       a->free_cnt = page_cnt;
+      set_page_arenas (a, 1, a);
+
+      old_level = intr_disable ();
+      count_request (&big_stats, size, page_cnt * PGSIZE);
+      intr_set_level (old_level);
       return a + 1;
     }
 
+  /* Find the smallest descriptor that satisfies a SIZE-byte
+     request. */
+  d = &descs[size_to_desc[DIV_ROUND_UP (size, CLASS_ALIGN)]];
+  ASSERT (d->block_size >= size);
+
   lock_acquire (&d->lock);
 
   /* If the free list is empty, create a new arena. */
@@ -126,8 +236,8 @@ malloc (size_t size)
     {
       size_t i;
 
-      /* Allocate a page. */
-      a = palloc_get_page (0);
+      /* Allocate pages. */
+      a = palloc_get_multiple (0, d->arena_pages);
       if (a == NULL) 
         {
           lock_release (&d->lock);
@@ -138,6 +248,8 @@ malloc (size_t size)
       a->magic = ARENA_MAGIC;
       a->desc = d;
       a->free_cnt = d->blocks_per_arena;
+      set_page_arenas (a, d->arena_pages, a);
+      d->arena_cnt++;
       for (i = 0; i < d->blocks_per_arena; i++) 
         {
           struct block *b = arena_to_block (a, i);
@@ -149,6 +261,8 @@ malloc (size_t size)
   b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
   a = block_to_arena (b);
   a->free_cnt--;
+  d->in_use++;
+  count_request (&d->stats, size, d->block_size);
   lock_release (&d->lock);
   return b;
 }
@@ -182,7 +296,7 @@ block_size (void *block)
   struct arena *a = block_to_arena (b);
   struct desc *d = a->desc;
 
-  return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs (block);
+  return d != NULL ? d->block_size : PGSIZE * a->free_cnt - sizeof *a;
 }
 
 /* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
@@ -237,6 +351,7 @@ free (void *p)
 
           /* Add block to free list. */
           list_push_front (&d->free_list, &b->free_elem);
+          d->in_use--;
 
           /* If the arena is now entirely unused, free it. */
           if (++a->free_cnt >= d->blocks_per_arena) 
@@ -249,7 +364,9 @@ free (void *p)
                   struct block *b = arena_to_block (a, i);
                   list_remove (&b->free_elem);
                 }
-              palloc_free_page (a);
+              set_page_arenas (a, d->arena_pages, NULL);
+              palloc_free_multiple (a, d->arena_pages);
+              d->arena_cnt--;
             }
 
           lock_release (&d->lock);
@@ -257,17 +374,88 @@ free (void *p)
       else
         {
           /* It's a big block.  Free its pages. */
+          set_page_arenas (a, 1, NULL);
           palloc_free_multiple (a, a->free_cnt);
           return;
         }
     }
 }
+
+/* Prints how much memory malloc() has handed out beyond what
+   was requested, over all requests so far, and how much the
+   power-of-2 size classes used before would have handed out for
+   the same requests.  Also prints the pages currently held in
+   arenas. */
+void
+malloc_print_stats (void) 
+{
+  struct malloc_stats total = big_stats;
+  size_t arena_pages = 0, in_use = 0, i;
+
+  for (i = 0; i < desc_cnt; i++) 
+    {
+      struct desc *d = &descs[i];
+      total.cnt += d->stats.cnt;
+      total.req_bytes += d->stats.req_bytes;
+      total.alloc_bytes += d->stats.alloc_bytes;
+      total.pow2_bytes += d->stats.pow2_bytes;
+      arena_pages += d->arena_cnt * d->arena_pages;
+      in_use += d->in_use;
+    }
+  if (total.cnt == 0)
+    return;
+
+  printf ("Malloc: %"PRIu64" requests for %"PRIu64" bytes, "
+          "%"PRIu64" bytes allocated (%"PRIu64"%% waste)\n",
+          total.cnt, total.req_bytes, total.alloc_bytes,
+          (total.alloc_bytes - total.req_bytes) * 100 / total.alloc_bytes);
+  printf ("Malloc: power-of-2 classes would allocate %"PRIu64" bytes "
+          "(%"PRIu64"%% waste)\n",
+          total.pow2_bytes,
+          (total.pow2_bytes - total.req_bytes) * 100 / total.pow2_bytes);
+  printf ("Malloc: %zu blocks in use in %zu arena pages\n",
+          in_use, arena_pages);
+}
 
+/* Adds a request for REQ bytes, satisfied by a block of ALLOC
+   bytes, to STATS. */
+static void
+count_request (struct malloc_stats *stats, size_t req, size_t alloc) 
+{
+  size_t pow2;
+
+  /* The old layout had classes of 16 to 1024 bytes, and
+     allocated whole pages for anything bigger. */
+  if (req <= 1024)
+    for (pow2 = 16; pow2 < req; pow2 *= 2)
+      continue;
+  else
+    pow2 = ROUND_UP (req + sizeof (struct arena), PGSIZE);
+
+  stats->cnt++;
+  stats->req_bytes += req;
+  stats->alloc_bytes += alloc;
+  stats->pow2_bytes += pow2;
+}
+
+/* Records arena A as the owner of the PAGE_CNT pages starting at
+   PAGES. */
+static void
+set_page_arenas (struct arena *pages, size_t page_cnt, struct arena *a) 
+{
+  size_t first = pg_no ((void *) vtop (pages));
+  size_t i;
+
+  ASSERT (first + page_cnt <= ram_pages);
+  for (i = 0; i < page_cnt; i++)
+    page_arenas[first + i] = a;
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
 {
-  struct arena *a = pg_round_down (b);
+  struct arena *a = page_arenas[pg_no ((void *) vtop (b))];
 
   /* Check that the arena is valid. */
   ASSERT (a != NULL);
@@ -275,8 +463,8 @@ block_to_arena (struct block *b)
 
   /* Check that the block is properly aligned for the arena. */
   ASSERT (a->desc == NULL
-          || (pg_ofs (b) - sizeof *a) % a->desc->block_size == 0);
-  ASSERT (a->desc != NULL || pg_ofs (b) == sizeof *a);
+          || ((uint8_t *) b - (uint8_t *) (a + 1)) % a->desc->block_size == 0);
+  ASSERT (a->desc != NULL || (void *) b == a + 1);
 
   return a;
 }
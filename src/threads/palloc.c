@@ -2,6 +2,7 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -9,8 +10,9 @@
 #include <string.h>
 #include "threads/init.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
+#include "threads/spinlock.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 
 /* Page allocator.  Hands out memory in page-size (or
    page-multiple) chunks.  See malloc.h for an allocator that
@@ -22,16 +24,107 @@
    that the kernel needs to have memory for its own operations
    even if user processes are swapping like mad.
 
-   By default, half of system RAM is given to the kernel pool and
-   half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   At startup, half of system RAM is given to the kernel pool and
+   half to the user pool.  The kernel pool sits below the user
+   pool, and the boundary between them moves at run time, one
+   BALANCE_CHUNK of pages at a time, toward whichever side is
+   under pressure:
+
+     - When the kernel pool's free pages drop below KERNEL_LOW,
+       it takes the lowest chunk of the user pool, if that chunk
+       is entirely free.
+
+     - When user processes evict frames at a high rate (see
+       palloc_note_eviction()), the user pool takes the highest
+       chunk of the kernel pool, if that chunk is entirely free
+       and the kernel pool keeps at least 2 * KERNEL_LOW free
+       pages afterward.
+
+   Neither pool shrinks below a quarter of its starting size,
+   which guarantees the kernel memory for its own operations, and
+   the user pool never grows past user_page_limit.  Free blocks
+   next to the boundary go to the back of their free lists, so
+   that they are used last and the boundary chunk tends to stay
+   free.
+
+   Each pool is a binary buddy allocator.  Its free pages are
+   grouped into blocks of 2**K pages that start at a page index,
+   relative to the base of free memory, that is a multiple of
+   2**K, and there is a free list of blocks for each order K.  A request for N
+   pages takes a block of the smallest order that fits, splitting
+   a larger block if necessary, and gives back the unused tail.
+   Freeing pages puts them back as the largest aligned blocks they
+   form, each of which is merged with its "buddy", the other half
+   of the block of the next order up, for as long as the buddy is
+   free too.  Both take O(lg n) time in the pool size.
+
+   A free block's list element lives in its first page, so the
+   only other bookkeeping is one byte per page holding the order
+   of the free block that starts there, if any.  The pool also
+   keeps a bitmap of allocated pages, to catch bad frees.  Both
+   pools keep these maps for all of free memory, at its start, so
+   that pages can move between them.  Each pool owns the pages in
+   its window [LO, HI) of the maps, and blocks never merge across
+   the window's edges.
+
+   A pool is protected by a spin lock rather than a struct lock,
+   because schedule_tail() frees a dying thread's page with
+   interrupts off, where it may not sleep.  The buddy operations
+   are short enough to run with interrupts off; zeroing and
+   poisoning pages happens outside the lock.
+
+   Each pool also keeps a small stock of free pages that have
+   already been zeroed, so that PAL_ZERO requests for single pages
+   (new threads, page tables, zero-filled user pages) need not
+   clear 4 kB while the caller waits.  The idle thread tops the
+   stock up by calling palloc_zero_idle() before it halts.  Pages
+   in the stock are taken out of the buddy free lists and marked
+   used.  They are handed to other requests only when the free
+   lists cannot satisfy them, so the stock never makes an
+   allocation fail. */
+
+/* Number of block orders: up to 2**(BUDDY_ORDERS - 1) pages. */
+#define BUDDY_ORDERS 20
+
+/* Entry in a pool's order map for a page that does not start a
+   free block. */
+#define NOT_FREE 0xff
+
+/* Most pages to keep zeroed in advance in each pool. */
+#define ZEROED_MAX 32
+
+/* Number of pages that move between pools at a time. */
+#define BALANCE_CHUNK 32
+
+/* The kernel pool grows when it has fewer free pages than this. */
+#define KERNEL_LOW 32
+
+/* The user pool grows after EVICT_BURST evictions within
+   EVICT_WINDOW timer ticks. */
+#define EVICT_BURST 16
+#define EVICT_WINDOW TIMER_FREQ
 
 /* A memory pool. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
-    uint8_t *base;                      /* Base of pool. */
+    struct spinlock lock;               /* Mutual exclusion. */
+    struct bitmap *used_map;            /* Bitmap of used pages. */
+    uint8_t *orders;                    /* Order of free block at each page. */
+    struct list free_lists[BUDDY_ORDERS]; /* Free blocks of each order. */
+    size_t free_cnt;                    /* Number of free pages. */
+    uint8_t *base;                      /* Base of free memory. */
+    size_t lo, hi;                      /* Pages owned: [LO, HI). */
+    size_t min_pages, max_pages;        /* Limits on HI - LO. */
+    const char *name;                   /* Name, for statistics. */
+    size_t start_pages;                 /* Pages owned at startup. */
+    size_t low_pages, high_pages;       /* Fewest and most pages owned. */
+    long long chunks_gained;            /* Chunks taken from other pool. */
+
+    /* Pages zeroed in advance. */
+    struct list zeroed;                 /* Zeroed pages, not in free lists. */
+    size_t zeroed_cnt;                  /* Number of pages in zeroed. */
+    long long zero_hits;                /* PAL_ZERO requests served by zeroed. */
+    long long zero_misses;              /* PAL_ZERO requests zeroed on demand. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -40,9 +133,26 @@ struct pool kernel_pool, user_pool;
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
 
-static void init_pool (struct pool *, void *base, size_t page_cnt,
+/* Evictions in the current window, and when it started.
+   Protected by user_pool's lock. */
+static unsigned evict_cnt;
+static int64_t evict_window_start;
+
+static void init_pool (struct pool *, void *maps, size_t map_cnt,
+                       uint8_t *base, size_t lo, size_t hi,
                        const char *name);
+static bool move_chunk (struct pool *from, struct pool *to);
+static void carve (struct pool *, size_t page_idx, size_t page_cnt);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
+static void buddy_free_block (struct pool *, size_t page_idx, int order);
+static struct list_elem *block_elem (struct pool *, size_t page_idx);
+static size_t pop_zeroed (struct pool *);
+static void flush_zeroed (struct pool *);
+static void flush_zeroed_range (struct pool *, size_t page_idx,
+                                size_t page_cnt);
+static void zero_pool (struct pool *);
 
 /* Initializes the page allocator. */
 void
@@ -56,16 +166,36 @@ palloc_init (void)
   uint8_t *free_start = pg_round_up (&_end);
   uint8_t *free_end = ptov (ram_pages * PGSIZE);
   size_t free_pages = (free_end - free_start) / PGSIZE;
-  size_t user_pages = free_pages / 2;
-  size_t kernel_pages;
+  size_t map_size, meta_pages, user_pages, kernel_pages;
+
+  /* We'll put each pool's used_map and order map, covering all of
+     free memory, at the start of free memory.  Calculate the
+     space needed for them and subtract it from free memory.  This
+     may count a few more pages than the maps need once they
+     shrink, which is harmless. */
+  map_size = bitmap_buf_size (free_pages) + free_pages;
+  meta_pages = DIV_ROUND_UP (2 * map_size, PGSIZE);
+  if (meta_pages >= free_pages)
+    PANIC ("Not enough memory for page allocator maps.");
+  free_pages -= meta_pages;
+  ASSERT (free_pages < (size_t) 1 << BUDDY_ORDERS);
+
+  /* Give half of memory to kernel, half to user. */
+  user_pages = free_pages / 2;
   if (user_pages > user_page_limit)
     user_pages = user_page_limit;
   kernel_pages = free_pages - user_pages;
 
-  /* Give half of memory to kernel, half to user. */
-  init_pool (&kernel_pool, free_start, kernel_pages, "kernel pool");
-  init_pool (&user_pool, free_start + kernel_pages * PGSIZE,
-             user_pages, "user pool");
+  init_pool (&kernel_pool, free_start, free_pages,
+             free_start + meta_pages * PGSIZE, 0, kernel_pages,
+             "kernel pool");
+  init_pool (&user_pool, free_start + map_size, free_pages,
+             free_start + meta_pages * PGSIZE, kernel_pages, free_pages,
+             "user pool");
+  kernel_pool.max_pages = free_pages - user_pool.min_pages;
+  user_pool.max_pages = free_pages - kernel_pool.min_pages;
+  if (user_pool.max_pages > user_page_limit)
+    user_pool.max_pages = user_page_limit;
 }
 
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
@@ -80,13 +210,54 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
   void *pages;
   size_t page_idx;
+  bool zeroed = false;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  /* Grow the kernel pool if it is running low.  Reading its free
+     count without the lock is fine for a heuristic. */
+  if (pool == &kernel_pool
+      && kernel_pool.free_cnt + kernel_pool.zeroed_cnt < KERNEL_LOW + page_cnt)
+    move_chunk (&user_pool, &kernel_pool);
+
+  spinlock_acquire (&pool->lock);
+  if (page_cnt == 1 && (flags & PAL_ZERO) && pool->zeroed_cnt > 0) 
+    {
+      page_idx = pop_zeroed (pool);
+      zeroed = true;
+    }
+  else 
+    {
+      page_idx = buddy_alloc (pool, page_cnt);
+      if (page_idx == BITMAP_ERROR && pool->zeroed_cnt > 0) 
+        {
+          /* Fall back on the zeroed pages. */
+          if (page_cnt == 1) 
+            {
+              page_idx = pop_zeroed (pool);
+              zeroed = true;
+            }
+          else 
+            {
+              flush_zeroed (pool);
+              page_idx = buddy_alloc (pool, page_cnt);
+            }
+        }
+      if (page_idx != BITMAP_ERROR && !zeroed)
+        {
+          ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+          bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+        }
+    }
+  if ((flags & PAL_ZERO) && page_idx != BITMAP_ERROR) 
+    {
+      if (zeroed)
+        pool->zero_hits++;
+      else
+        pool->zero_misses++;
+    }
+  spinlock_release (&pool->lock);
 
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
@@ -95,8 +266,10 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 
   if (pages != NULL) 
     {
+      /* A zeroed page has only its list element to clear. */
       if (flags & PAL_ZERO)
-        memset (pages, 0, PGSIZE * page_cnt);
+        memset (pages, 0, zeroed ? sizeof (struct list_elem)
+                                 : PGSIZE * page_cnt);
     }
   else 
     {
@@ -144,8 +317,11 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
+  spinlock_acquire (&pool->lock);
   ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
   bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  buddy_free (pool, page_idx, page_cnt);
+  spinlock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
@@ -155,25 +331,449 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
-/* Initializes pool P as starting at START and ending at END,
-   naming it NAME for debugging purposes. */
+/* Stores in *FREE_CNT the number of free pages in the user pool,
+   if PAL_USER is set in FLAGS, or else in the kernel pool, and in
+   *LARGEST_CNT the number of pages in its largest free block,
+   which bounds the largest request it can satisfy.  Puts the
+   pool's zeroed pages back in its free lists first, so that both
+   counts cover them. */
+void
+palloc_get_stats (enum palloc_flags flags, size_t *free_cnt,
+                  size_t *largest_cnt) 
+{
+  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  int order;
+
+  spinlock_acquire (&pool->lock);
+  flush_zeroed (pool);
+  *free_cnt = pool->free_cnt;
+  *largest_cnt = 0;
+  for (order = BUDDY_ORDERS - 1; order >= 0; order--)
+    if (!list_empty (&pool->free_lists[order]))
+      {
+        *largest_cnt = (size_t) 1 << order;
+        break;
+      }
+  spinlock_release (&pool->lock);
+}
+
+/* Returns the number of free pages in the user pool, if PAL_USER
+   is set in FLAGS, or else the kernel pool, counting its zeroed
+   pages.  Unlike palloc_get_stats(), leaves the zeroed pages be, so
+   it is cheap enough to poll. */
+size_t
+palloc_free_cnt (enum palloc_flags flags) 
+{
+  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  size_t cnt;
+
+  spinlock_acquire (&pool->lock);
+  cnt = pool->free_cnt + pool->zeroed_cnt;
+  spinlock_release (&pool->lock);
+  return cnt;
+}
+
+/* Stores in *HITS the number of single-page PAL_ZERO requests to
+   the user pool, if PAL_USER is set in FLAGS, or else the kernel
+   pool, that were served by a page zeroed in advance, and in
+   *MISSES the number of PAL_ZERO requests that had to zero their
+   pages on the spot. */
+void
+palloc_get_zero_stats (enum palloc_flags flags, long long *hits,
+                       long long *misses) 
+{
+  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+
+  spinlock_acquire (&pool->lock);
+  *hits = pool->zero_hits;
+  *misses = pool->zero_misses;
+  spinlock_release (&pool->lock);
+}
+
+/* Zeroes free pages in advance, until each pool has ZEROED_MAX
+   of them or runs out of free pages.  Called by the idle thread
+   with interrupts on, so that any thread that becomes ready
+   preempts it. */
+void
+palloc_zero_idle (void) 
+{
+  zero_pool (&kernel_pool);
+  zero_pool (&user_pool);
+}
+
+/* Records that a user frame was evicted to make room for another
+   user page.  Called by the frame table.  If evictions are coming
+   fast, moves a chunk of the kernel pool to the user pool. */
+void
+palloc_note_eviction (void) 
+{
+  int64_t now = timer_ticks ();
+  bool grow = false;
+
+  spinlock_acquire (&user_pool.lock);
+  if (now - evict_window_start >= EVICT_WINDOW) 
+    {
+      evict_window_start = now;
+      evict_cnt = 0;
+    }
+  if (++evict_cnt >= EVICT_BURST) 
+    {
+      evict_window_start = now;
+      evict_cnt = 0;
+      grow = true;
+    }
+  spinlock_release (&user_pool.lock);
+
+  if (grow)
+    move_chunk (&kernel_pool, &user_pool);
+}
+
+/* Stores in *BASE the first page that either pool may hand out,
+   and in *PAGE_CNT the number of pages from there on that the two
+   pools share.  The boundary between the pools moves within this
+   range, but the range itself never changes, so it can be used to
+   index per-page data for user pages. */
+void
+palloc_get_range (void **base, size_t *page_cnt) 
+{
+  *base = user_pool.base;
+  *page_cnt = bitmap_size (user_pool.used_map);
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) 
+{
+  struct pool *pools[] = {&kernel_pool, &user_pool};
+  size_t i;
+
+  for (i = 0; i < sizeof pools / sizeof *pools; i++) 
+    {
+      struct pool *pool = pools[i];
+      printf ("Palloc: %s: %lld zeroed pages served from stock, "
+              "%lld zeroed on demand\n",
+              pool->name, pool->zero_hits, pool->zero_misses);
+      printf ("Palloc: %s: %zu pages (%zu at start, %zu to %zu), "
+              "%lld chunks of %d pages gained\n",
+              pool->name, pool->hi - pool->lo, pool->start_pages,
+              pool->low_pages, pool->high_pages, pool->chunks_gained,
+              BALANCE_CHUNK);
+    }
+}
+
+/* Initializes pool P to own pages LO through HI - 1 of the
+   MAP_CNT pages of free memory starting at BASE, keeping its maps
+   at MAPS, and names it NAME for debugging purposes. */
 static void
-init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
+init_pool (struct pool *p, void *maps, size_t map_cnt, uint8_t *base,
+           size_t lo, size_t hi, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
-    PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  size_t bm_size = bitmap_buf_size (map_cnt);
+  int order;
 
-  printf ("%zu pages available in %s.\n", page_cnt, name);
+  printf ("%zu pages available in %s.\n", hi - lo, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  spinlock_init (&p->lock);
+  p->used_map = bitmap_create_in_buf (map_cnt, maps, bm_size);
+  p->orders = (uint8_t *) maps + bm_size;
+  memset (p->orders, NOT_FREE, map_cnt);
+  for (order = 0; order < BUDDY_ORDERS; order++)
+    list_init (&p->free_lists[order]);
+  p->free_cnt = 0;
+  p->base = base;
+  p->lo = lo;
+  p->hi = hi;
+  p->min_pages = (hi - lo) / 4;
+  p->max_pages = hi - lo;
+  p->name = name;
+  p->start_pages = p->low_pages = p->high_pages = hi - lo;
+  p->chunks_gained = 0;
+  list_init (&p->zeroed);
+  p->zeroed_cnt = 0;
+  p->zero_hits = p->zero_misses = 0;
+
+  buddy_free (p, lo, hi - lo);
+}
+
+/* Returns the order of the smallest block holding PAGE_CNT
+   pages. */
+static int
+order_for (size_t page_cnt) 
+{
+  int order = 0;
+
+  while (((size_t) 1 << order) < page_cnt)
+    order++;
+  return order;
+}
+
+/* Takes PAGE_CNT contiguous pages out of POOL's free lists and
+   returns the index of the first, or BITMAP_ERROR if there is no
+   free block big enough. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt) 
+{
+  int want = order_for (page_cnt);
+  int order;
+  size_t page_idx;
+
+  if (want >= BUDDY_ORDERS)
+    return BITMAP_ERROR;
+  for (order = want; order < BUDDY_ORDERS; order++)
+    if (!list_empty (&pool->free_lists[order]))
+      break;
+  if (order == BUDDY_ORDERS)
+    return BITMAP_ERROR;
+
+  page_idx = pg_no (list_pop_front (&pool->free_lists[order]))
+             - pg_no (pool->base);
+  ASSERT (pool->orders[page_idx] == order);
+  pool->orders[page_idx] = NOT_FREE;
+  pool->free_cnt -= (size_t) 1 << order;
+
+  /* Split off the upper halves until the block is the size we
+     want.  They cannot merge with anything. */
+  while (order > want) 
+    {
+      order--;
+      pool->orders[page_idx + ((size_t) 1 << order)] = order;
+      list_push_front (&pool->free_lists[order],
+                       block_elem (pool, page_idx + ((size_t) 1 << order)));
+      pool->free_cnt += (size_t) 1 << order;
+    }
+
+  /* Give back the pages past PAGE_CNT. */
+  buddy_free (pool, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+  return page_idx;
+}
+
+/* Returns the PAGE_CNT pages starting at PAGE_IDX to POOL's free
+   lists, as the largest aligned blocks that they form. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  while (page_cnt > 0) 
+    {
+      int order = 0;
+
+      while (order + 1 < BUDDY_ORDERS
+             && page_idx % ((size_t) 2 << order) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+      buddy_free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Returns the block of 2**ORDER pages at PAGE_IDX to POOL's free
+   lists, merging it with its buddy for as long as the buddy is a
+   free block of the same order. */
+static void
+buddy_free_block (struct pool *pool, size_t page_idx, int order) 
+{
+  struct list_elem *elem;
+
+  pool->free_cnt += (size_t) 1 << order;
+  while (order + 1 < BUDDY_ORDERS) 
+    {
+      size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+      if (buddy < pool->lo || buddy + ((size_t) 1 << order) > pool->hi
+          || pool->orders[buddy] != order)
+        break;
+      list_remove (block_elem (pool, buddy));
+      pool->orders[buddy] = NOT_FREE;
+      if (buddy < page_idx)
+        page_idx = buddy;
+      order++;
+    }
+  pool->orders[page_idx] = order;
+
+  /* Keep blocks in the chunk next to the other pool for last. */
+  elem = block_elem (pool, page_idx);
+  if (pool == &kernel_pool
+      ? page_idx + ((size_t) 1 << order) > pool->hi - BALANCE_CHUNK
+      : page_idx < pool->lo + BALANCE_CHUNK)
+    list_push_back (&pool->free_lists[order], elem);
+  else
+    list_push_front (&pool->free_lists[order], elem);
+}
+
+/* Moves one BALANCE_CHUNK of pages, next to the boundary between
+   the pools, from pool FROM to pool TO, if FROM can spare them.
+   Returns true if successful, false if the pools are unchanged. */
+static bool
+move_chunk (struct pool *from, struct pool *to) 
+{
+  size_t start;
+  bool ok = false;
+
+  /* Always lock the kernel pool first. */
+  spinlock_acquire (&kernel_pool.lock);
+  spinlock_acquire (&user_pool.lock);
+
+  start = from == &kernel_pool ? from->hi - BALANCE_CHUNK : from->lo;
+  if (from->hi - from->lo < from->min_pages + BALANCE_CHUNK
+      || to->hi - to->lo + BALANCE_CHUNK > to->max_pages)
+    goto done;
+  if (from == &kernel_pool
+      && from->free_cnt + from->zeroed_cnt < 2 * KERNEL_LOW + BALANCE_CHUNK)
+    goto done;
+
+  flush_zeroed_range (from, start, BALANCE_CHUNK);
+  if (!bitmap_none (from->used_map, start, BALANCE_CHUNK))
+    goto done;
+
+  /* Shrink FROM's window first, so that what carve() gives back
+     cannot merge into the chunk, then grow TO's. */
+  if (from == &kernel_pool) 
+    {
+      from->hi -= BALANCE_CHUNK;
+      to->lo -= BALANCE_CHUNK;
+    }
+  else 
+    {
+      from->lo += BALANCE_CHUNK;
+      to->hi += BALANCE_CHUNK;
+    }
+  carve (from, start, BALANCE_CHUNK);
+  buddy_free (to, start, BALANCE_CHUNK);
+
+  to->chunks_gained++;
+  if (from->hi - from->lo < from->low_pages)
+    from->low_pages = from->hi - from->lo;
+  if (to->hi - to->lo > to->high_pages)
+    to->high_pages = to->hi - to->lo;
+  ok = true;
+
+ done:
+  spinlock_release (&user_pool.lock);
+  spinlock_release (&kernel_pool.lock);
+  return ok;
+}
+
+/* Takes the PAGE_CNT free pages starting at PAGE_IDX out of
+   POOL's free lists.  Any free block that extends past them is
+   split, and the rest of it goes back into the free lists. */
+static void
+carve (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  size_t idx = page_idx;
+  size_t end = page_idx + page_cnt;
+
+  while (idx < end) 
+    {
+      size_t block, block_end;
+      int order;
+
+      /* Find the free block that holds page IDX. */
+      for (order = 0; order < BUDDY_ORDERS; order++) 
+        {
+          block = idx & ~(((size_t) 1 << order) - 1);
+          if (pool->orders[block] == order)
+            break;
+        }
+      ASSERT (order < BUDDY_ORDERS);
+      block_end = block + ((size_t) 1 << order);
+
+      list_remove (block_elem (pool, block));
+      pool->orders[block] = NOT_FREE;
+      pool->free_cnt -= (size_t) 1 << order;
+
+      /* Give back the parts outside the range. */
+      if (block < page_idx)
+        buddy_free (pool, block, page_idx - block);
+      if (block_end > end)
+        buddy_free (pool, end, block_end - end);
+      idx = block_end;
+    }
+}
+
+/* Returns the free list element stored at the start of the free
+   block at PAGE_IDX in POOL. */
+static struct list_elem *
+block_elem (struct pool *pool, size_t page_idx) 
+{
+  return (struct list_elem *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Removes a page from POOL's zeroed pages and returns its index.
+   The page stays marked used.  POOL's lock must be held. */
+static size_t
+pop_zeroed (struct pool *pool) 
+{
+  ASSERT (pool->zeroed_cnt > 0);
+  pool->zeroed_cnt--;
+  return pg_no (list_pop_front (&pool->zeroed)) - pg_no (pool->base);
+}
+
+/* Returns all of POOL's zeroed pages to its free lists.  POOL's
+   lock must be held. */
+static void
+flush_zeroed (struct pool *pool) 
+{
+  while (pool->zeroed_cnt > 0) 
+    {
+      size_t page_idx = pop_zeroed (pool);
+      bitmap_reset (pool->used_map, page_idx);
+      buddy_free (pool, page_idx, 1);
+    }
+}
+
+/* Returns those of POOL's zeroed pages that lie within the
+   PAGE_CNT pages starting at PAGE_IDX to its free lists.  POOL's
+   lock must be held. */
+static void
+flush_zeroed_range (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  struct list_elem *e, *next;
+
+  for (e = list_begin (&pool->zeroed); e != list_end (&pool->zeroed);
+       e = next) 
+    {
+      size_t idx = pg_no (e) - pg_no (pool->base);
+
+      next = list_next (e);
+      if (idx >= page_idx && idx < page_idx + page_cnt) 
+        {
+          list_remove (e);
+          pool->zeroed_cnt--;
+          bitmap_reset (pool->used_map, idx);
+          buddy_free (pool, idx, 1);
+        }
+    }
+}
+
+/* Zeroes free pages of POOL until it has ZEROED_MAX zeroed pages
+   or no free pages.  Only the idle thread calls this, so there is
+   at most one page being zeroed at a time. */
+static void
+zero_pool (struct pool *pool) 
+{
+  for (;;) 
+    {
+      size_t page_idx = BITMAP_ERROR;
+      uint8_t *page;
+
+      spinlock_acquire (&pool->lock);
+      if (pool->zeroed_cnt < ZEROED_MAX)
+        page_idx = buddy_alloc (pool, 1);
+      if (page_idx != BITMAP_ERROR)
+        bitmap_mark (pool->used_map, page_idx);
+      spinlock_release (&pool->lock);
+      if (page_idx == BITMAP_ERROR)
+        break;
+
+      page = pool->base + PGSIZE * page_idx;
+      memset (page, 0, PGSIZE);
+
+      spinlock_acquire (&pool->lock);
+      list_push_front (&pool->zeroed, (struct list_elem *) page);
+      pool->zeroed_cnt++;
+      spinlock_release (&pool->lock);
+    }
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -182,8 +782,8 @@ static bool
 page_from_pool (const struct pool *pool, void *page) 
 {
   size_t page_no = pg_no (page);
-  size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t start_page = pg_no (pool->base) + pool->lo;
+  size_t end_page = pg_no (pool->base) + pool->hi;
 
   return page_no >= start_page && page_no < end_page;
 }
@@ -19,5 +19,14 @@ void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void palloc_get_stats (enum palloc_flags, size_t *free_cnt,
+                       size_t *largest_cnt);
+size_t palloc_free_cnt (enum palloc_flags);
+void palloc_get_zero_stats (enum palloc_flags, long long *hits,
+                            long long *misses);
+void palloc_zero_idle (void);
+void palloc_note_eviction (void);
+void palloc_get_range (void **base, size_t *page_cnt);
+void palloc_print_stats (void);
 
 #endif /* threads/palloc.h */
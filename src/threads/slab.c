@@ -0,0 +1,242 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Object caches.  See slab.h for basic information.
+
+   Each slab is one page from the kernel pool.  It starts with a
+   struct slab header, followed by as many objects as fit.  The
+   free objects in a slab form a singly linked list through their
+   first word.  A cache keeps its slabs on a list of partially
+   used slabs, from which it allocates, and a list of full ones,
+   and holds on to at most one completely free slab, so that a
+   cache whose use goes up and down around a slab boundary does not
+   keep going back to the page allocator.
+
+   Freeing an object finds its slab by rounding its address down
+   to a page boundary. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x5ab1ca5e
+
+/* A slab. */
+struct slab 
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in cache's partial or full. */
+    size_t free_cnt;            /* Free objects. */
+    struct free_obj *free;      /* First free object. */
+  };
+
+/* A free object. */
+struct free_obj 
+  {
+    struct free_obj *next;      /* Next free object in slab. */
+  };
+
+/* All caches, most recently initialized first. */
+static struct kmem_cache *caches;
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (void *);
+
+/* Initializes CACHE to hand out objects of SIZE bytes, naming it
+   NAME for statistics.  If CTOR is nonnull, it is called on each
+   object as its slab is created.  CACHE is registered for
+   kmem_print_stats() and must never be destroyed. */
+void
+kmem_cache_init (struct kmem_cache *cache, const char *name, size_t size,
+                 kmem_ctor_func *ctor) 
+{
+  enum intr_level old_level;
+
+  ASSERT (cache != NULL);
+  ASSERT (size > 0);
+
+  cache->name = name;
+  cache->obj_size = size;
+  cache->slot_size = ROUND_UP (size < sizeof (struct free_obj)
+                               ? sizeof (struct free_obj) : size,
+                               sizeof (void *));
+  cache->objs_per_slab = (PGSIZE - sizeof (struct slab)) / cache->slot_size;
+  ASSERT (cache->objs_per_slab > 0);
+  cache->ctor = ctor;
+  lock_init_named (&cache->lock, name);
+  list_init (&cache->partial);
+  list_init (&cache->full);
+  cache->empty = NULL;
+  cache->slab_cnt = 0;
+  cache->in_use = 0;
+  cache->max_in_use = 0;
+
+  old_level = intr_disable ();
+  cache->next = caches;
+  caches = cache;
+  intr_set_level (old_level);
+}
+
+/* Obtains and returns an object from CACHE, or a null pointer if
+   memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *cache) 
+{
+  struct slab *s;
+  struct free_obj *obj;
+
+  ASSERT (cache != NULL);
+
+  lock_acquire (&cache->lock);
+
+  /* Find a slab with a free object, creating one if necessary. */
+  if (list_empty (&cache->partial)) 
+    {
+      s = cache->empty;
+      cache->empty = NULL;
+      if (s == NULL)
+        s = slab_create (cache);
+      if (s == NULL) 
+        {
+          lock_release (&cache->lock);
+          return NULL;
+        }
+      list_push_front (&cache->partial, &s->elem);
+    }
+  s = list_entry (list_front (&cache->partial), struct slab, elem);
+
+  /* Take an object from it. */
+  obj = s->free;
+  s->free = obj->next;
+  if (--s->free_cnt == 0) 
+    {
+      list_remove (&s->elem);
+      list_push_front (&cache->full, &s->elem);
+    }
+  if (++cache->in_use > cache->max_in_use)
+    cache->max_in_use = cache->in_use;
+
+  lock_release (&cache->lock);
+  return obj;
+}
+
+/* Returns OBJ, which must have come from CACHE, to CACHE.  Does
+   nothing if OBJ is a null pointer. */
+void
+kmem_cache_free (struct kmem_cache *cache, void *obj_) 
+{
+  struct free_obj *obj = obj_;
+  struct slab *s;
+
+  if (obj == NULL)
+    return;
+
+  s = obj_to_slab (obj);
+  ASSERT (s->cache == cache);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs, unless
+     it has to stay constructed. */
+  if (cache->ctor == NULL)
+    memset (obj, 0xcc, cache->obj_size);
+#endif
+
+  lock_acquire (&cache->lock);
+
+  obj->next = s->free;
+  s->free = obj;
+  cache->in_use--;
+  if (++s->free_cnt == 1) 
+    {
+      /* It was full. */
+      list_remove (&s->elem);
+      list_push_front (&cache->partial, &s->elem);
+    }
+  if (s->free_cnt == cache->objs_per_slab) 
+    {
+      /* It is empty now.  Keep it if we have no empty slab yet,
+         otherwise give it back. */
+      list_remove (&s->elem);
+      if (cache->empty == NULL)
+        cache->empty = s;
+      else 
+        {
+          s->magic = 0;
+          palloc_free_page (s);
+          cache->slab_cnt--;
+        }
+    }
+
+  lock_release (&cache->lock);
+}
+
+/* Prints, for each cache that has been used, how many objects it
+   has handed out and how many bytes its slabs spend on anything
+   but objects in use: headers, padding, and free objects. */
+void
+kmem_print_stats (void) 
+{
+  struct kmem_cache *c;
+
+  for (c = caches; c != NULL; c = c->next)
+    if (c->max_in_use > 0)
+      printf ("Slab: %s: %zu of %zu-byte objects in use (%zu max), "
+              "%zu slabs of %zu, %zu bytes wasted\n",
+              c->name, c->in_use, c->obj_size, c->max_in_use,
+              c->slab_cnt, c->objs_per_slab,
+              c->slab_cnt * PGSIZE - c->in_use * c->obj_size);
+}
+
+/* Creates and returns a new slab for CACHE, with all of its
+   objects free and constructed, or returns a null pointer if no
+   page is available.  CACHE's lock must be held. */
+static struct slab *
+slab_create (struct kmem_cache *cache) 
+{
+  struct slab *s;
+  uint8_t *objs;
+  size_t i;
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = cache;
+  s->free_cnt = cache->objs_per_slab;
+  s->free = NULL;
+
+  /* Thread the objects onto the free list back to front, so that
+     they are handed out in address order. */
+  objs = (uint8_t *) (s + 1);
+  for (i = cache->objs_per_slab; i-- > 0; ) 
+    {
+      struct free_obj *obj = (struct free_obj *) (objs + i * cache->slot_size);
+      if (cache->ctor != NULL)
+        cache->ctor (obj);
+      obj->next = s->free;
+      s->free = obj;
+    }
+
+  cache->slab_cnt++;
+  return s;
+}
+
+/* Returns the slab that object OBJ is inside. */
+static struct slab *
+obj_to_slab (void *obj) 
+{
+  struct slab *s = pg_round_down (obj);
+
+  /* Check that the slab is valid. */
+  ASSERT (s != NULL);
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT ((uint8_t *) obj >= (uint8_t *) (s + 1));
+
+  return s;
+}
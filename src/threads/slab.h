@@ -0,0 +1,48 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* Object caches.
+
+   A kmem_cache hands out objects of one fixed size, carved from
+   whole pages ("slabs") obtained from the kernel pool.  Compared
+   to malloc(), an object takes only its own size rounded up to a
+   word rather than up to a power of two, and allocating or
+   freeing one touches only its cache, without searching.
+
+   If a cache has a constructor, it is called once for each object
+   when the slab holding it is created, not on every allocation.
+   Such objects must be freed in their constructed state, so that
+   the next user can rely on it. */
+
+/* Constructor for an object cache. */
+typedef void kmem_ctor_func (void *obj);
+
+/* Object cache. */
+struct kmem_cache 
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t obj_size;            /* Bytes requested per object. */
+    size_t slot_size;           /* Bytes each object takes in a slab. */
+    size_t objs_per_slab;       /* Objects in each slab. */
+    kmem_ctor_func *ctor;       /* Constructor, or NULL. */
+    struct lock lock;           /* Protects the members below. */
+    struct list partial;        /* Slabs with some objects free. */
+    struct list full;           /* Slabs with no objects free. */
+    struct slab *empty;         /* A slab with all objects free, or NULL. */
+    size_t slab_cnt;            /* Slabs owned. */
+    size_t in_use;              /* Objects allocated. */
+    size_t max_in_use;          /* Most objects ever allocated at once. */
+    struct kmem_cache *next;    /* Next cache in the registry. */
+  };
+
+void kmem_cache_init (struct kmem_cache *, const char *name, size_t size,
+                      kmem_ctor_func *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+void kmem_print_stats (void);
+
+#endif /* threads/slab.h */
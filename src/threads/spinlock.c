@@ -0,0 +1,70 @@
+#include "threads/spinlock.h"
+#include <debug.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Initializes LOCK as free. */
+void
+spinlock_init (struct spinlock *lock) 
+{
+  ASSERT (lock != NULL);
+
+  lock->locked = 0;
+  lock->holder = NULL;
+  lock->old_level = INTR_OFF;
+}
+
+/* Acquires LOCK, turning interrupts off until it is released.
+   The lock must not already be held by the current thread.
+
+   This function does not sleep, so it may be called within an
+   interrupt handler. */
+void
+spinlock_acquire (struct spinlock *lock) 
+{
+  enum intr_level old_level;
+  uint32_t was_locked;
+
+  ASSERT (lock != NULL);
+  ASSERT (!spinlock_held_by_current_thread (lock));
+
+  old_level = intr_disable ();
+  for (;;) 
+    {
+      was_locked = 1;
+      asm volatile ("xchgl %0, %1"
+                    : "+r" (was_locked), "+m" (lock->locked) : : "memory");
+      if (!was_locked)
+        break;
+      asm volatile ("pause");
+    }
+  lock->holder = thread_current ();
+  lock->old_level = old_level;
+}
+
+/* Releases LOCK, which must be held by the current thread, and
+   restores the interrupt level from before it was acquired. */
+void
+spinlock_release (struct spinlock *lock) 
+{
+  enum intr_level old_level;
+
+  ASSERT (lock != NULL);
+  ASSERT (spinlock_held_by_current_thread (lock));
+
+  old_level = lock->old_level;
+  lock->holder = NULL;
+  barrier ();
+  lock->locked = 0;
+  intr_set_level (old_level);
+}
+
+/* Returns true if the current thread holds LOCK, false
+   otherwise. */
+bool
+spinlock_held_by_current_thread (const struct spinlock *lock) 
+{
+  ASSERT (lock != NULL);
+
+  return lock->locked && lock->holder == thread_current ();
+}
@@ -0,0 +1,32 @@
+#ifndef THREADS_SPINLOCK_H
+#define THREADS_SPINLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+
+/* Spin lock.
+
+   Protects data that interrupt handlers also touch, for as long
+   as it takes to update it.  Acquiring one turns interrupts off,
+   so that the holder cannot be interrupted or preempted, and then
+   takes the lock with an atomic exchange, which is what would
+   keep out other CPUs.  The holder must not sleep.
+
+   On a uniprocessor the exchange always succeeds, and a spin lock
+   costs about as much as the intr_disable()/intr_set_level() pair
+   it replaces, but it names what it protects, and it catches
+   recursive acquisition. */
+struct spinlock 
+  {
+    volatile uint32_t locked;   /* 1 if held, 0 if free. */
+    struct thread *holder;      /* Thread holding lock (for debugging). */
+    enum intr_level old_level;  /* Interrupt level before acquiring. */
+  };
+
+void spinlock_init (struct spinlock *);
+void spinlock_acquire (struct spinlock *);
+void spinlock_release (struct spinlock *);
+bool spinlock_held_by_current_thread (const struct spinlock *);
+
+#endif /* threads/spinlock.h */
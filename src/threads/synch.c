@@ -31,6 +31,7 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -47,7 +48,7 @@ sema_init (struct semaphore *sema, unsigned value)
   ASSERT (sema != NULL);
 
   sema->value = value;
-  list_init (&sema->waiters);
+  pqueue_init (&sema->waiters, priority_sema, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -68,7 +69,9 @@ sema_down (struct semaphore *sema)
   old_level = intr_disable ();
   while (sema->value == 0) 
   {
-    list_push_back (&(sema->waiters), &thread_current ()->elem);
+    struct thread *cur = thread_current ();
+    cur->wait_queue = &sema->waiters;
+    pqueue_push (&sema->waiters, &cur->wait_elem);
     thread_block ();
   }
   sema->value--;
@@ -103,29 +106,37 @@ sema_try_down (struct semaphore *sema)
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
    and wakes up one thread of those waiting for SEMA, if any.
+   The running thread yields to the woken thread only if that
+   thread should preempt it, and never if the caller had turned
+   interrupts off, since the caller then expects to keep running
+   atomically.
 
    This function may be called from an interrupt handler. */
 void
 sema_up (struct semaphore *sema) 
 {
   enum intr_level old_level;
-  struct thread *t = NULL;
+  bool yield = false;
   ASSERT (sema != NULL);
   old_level = intr_disable ();
-  if (!list_empty (&sema->waiters))
+  if (!pqueue_empty (&sema->waiters))
   {
-    struct list_elem *e = list_max (&sema->waiters, priority_sema, NULL);
-    list_remove (e);
-    t = list_entry (e, struct thread, elem);
-    thread_unblock (t);  
+    struct pqueue_elem *e = pqueue_pop_max (&sema->waiters);
+    struct thread *t = pqueue_entry (e, struct thread, wait_elem);
+    t->wait_queue = NULL;
+    thread_unblock (t);
+    if (thread_should_preempt (t))
+    {
+      if (intr_context ())
+        intr_yield_on_return ();
+      else
+        yield = old_level == INTR_ON;
+    }
   }
   sema->value++;
   intr_set_level (old_level);
-  struct thread *cur = thread_current ();
-  if (t == NULL || cur->no_yield == true)
-      cur->no_yield = false;
-  else
-     thread_yield();
+  if (yield)
+    thread_yield ();
 }
 
 static void sema_test_helper (void *sema_);
@@ -187,6 +198,58 @@ lock_init (struct lock *lock)
 
   lock->holder = NULL;
   sema_init (&lock->semaphore, 1);
+  lock->name = NULL;
+  lock->next_named = NULL;
+  memset (&lock->stat, 0, sizeof lock->stat);
+}
+
+/* Most contended locks to print at shutdown, or 0 to keep no
+   lock statistics.  Set by the -lockstat kernel option. */
+int lock_stat_top;
+
+/* Locks registered by lock_init_named(), most recent first. */
+static struct lock *lock_registry;
+
+/* Initializes LOCK, like lock_init(), and registers it under
+   NAME so that its contention statistics are reported at
+   shutdown.  A registered lock is never unregistered, so LOCK
+   and NAME must outlive the kernel: use this for locks in static
+   storage or in structures that are never freed. */
+void
+lock_init_named (struct lock *lock, const char *name)
+{
+  enum intr_level old_level;
+
+  ASSERT (name != NULL);
+
+  lock_init (lock);
+  lock->name = name;
+
+  old_level = intr_disable ();
+  lock->next_named = lock_registry;
+  lock_registry = lock;
+  intr_set_level (old_level);
+}
+
+/* Records in LOCK's statistics that the current thread just
+   acquired it after starting to try at tick START, having had to
+   wait if CONTENDED. */
+static void
+lock_stat_acquired (struct lock *lock, int64_t start, bool contended)
+{
+  struct lock_stat *s = &lock->stat;
+  int64_t now = timer_ticks ();
+
+  s->acquisitions++;
+  if (contended)
+    {
+      int64_t wait = now - start;
+      s->contended++;
+      s->wait_ticks += wait;
+      if (wait > s->max_wait)
+        s->max_wait = wait;
+    }
+  s->acquired_at = now;
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -204,12 +267,36 @@ lock_acquire (struct lock *lock)
   ASSERT (!lock_held_by_current_thread (lock));
   ASSERT (!intr_context ());
 
-  sema_down (&lock->semaphore);
   struct thread * cur_thread =thread_current ();
+  enum intr_level old_level = intr_disable ();
+  bool contended = lock->holder != NULL;
+  int64_t start = lock_stat_top ? timer_ticks () : 0;
+  if (contended && !thread_mlfqs)
+  {
+    // Donate our priority to the holder, and through it to whatever
+    // chain of holders it is itself waiting on
+    cur_thread->waiting_lock = lock;
+    thread_donate_priority (lock->holder, cur_thread->eff_priority);
+  }
+
+  sema_down (&lock->semaphore);
+  cur_thread->waiting_lock = NULL;
   // Created a waiting list for the lock
   list_push_back (&cur_thread->locks_acquired, &lock->locks_acquired_elem);
   lock->holder = cur_thread;
+  if (lock_stat_top)
+    lock_stat_acquired (lock, start, contended);
 
+  // Threads still queued on the lock now donate to us; the first
+  // of them has the highest priority
+  if (!thread_mlfqs && !pqueue_empty (&lock->semaphore.waiters))
+  {
+    struct thread *w = pqueue_entry (pqueue_max (&lock->semaphore.waiters),
+                                     struct thread, wait_elem);
+    if (w->eff_priority > cur_thread->eff_priority)
+      cur_thread->eff_priority = w->eff_priority;
+  }
+  intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -228,7 +315,13 @@ lock_try_acquire (struct lock *lock)
 
   success = sema_try_down (&lock->semaphore);
   if (success)
+  {
+    // Track it like lock_acquire() does, so lock_release() can drop it
+    list_push_back (&thread_current ()->locks_acquired, &lock->locks_acquired_elem);
     lock->holder = thread_current ();
+    if (lock_stat_top)
+      lock_stat_acquired (lock, 0, false);
+  }
   return success;
 }
 
@@ -243,9 +336,20 @@ lock_release (struct lock *lock)
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
+  enum intr_level old_level = intr_disable ();
+  if (lock_stat_top)
+  {
+    int64_t hold = timer_ticks () - lock->stat.acquired_at;
+    if (hold > lock->stat.max_hold)
+      lock->stat.max_hold = hold;
+  }
   lock->holder = NULL;
   // removed the element that releases the lock
   list_remove(&lock->locks_acquired_elem);
+  // and with it any priority its waiters were donating to us
+  if (!thread_mlfqs)
+    thread_recompute_priority (thread_current ());
+  intr_set_level (old_level);
   sema_up (&lock->semaphore); 
 }
 
@@ -259,12 +363,67 @@ lock_held_by_current_thread (const struct lock *lock)
 
   return lock->holder == thread_current ();
 }
+
+/* Most locks lock_print_stats() will report. */
+#define LOCK_STAT_TOP_MAX 32
+
+/* Returns true if A has seen more contention than B: more
+   contended acquisitions, or as many but more time waiting. */
+static bool
+lock_stat_more (const struct lock *a, const struct lock *b)
+{
+  if (a->stat.contended != b->stat.contended)
+    return a->stat.contended > b->stat.contended;
+  return a->stat.wait_ticks > b->stat.wait_ticks;
+}
+
+/* Prints the lock_stat_top most contended registered locks. */
+void
+lock_print_stats (void)
+{
+  struct lock *top[LOCK_STAT_TOP_MAX];
+  int top_cnt = 0;
+  int max = lock_stat_top < LOCK_STAT_TOP_MAX ? lock_stat_top : LOCK_STAT_TOP_MAX;
+  size_t lock_cnt = 0;
+  struct lock *l;
+  int i;
+
+  if (lock_stat_top <= 0)
+    return;
+
+  /* Insertion sort into TOP, dropping whatever falls off the end. */
+  for (l = lock_registry; l != NULL; l = l->next_named)
+    {
+      lock_cnt++;
+      for (i = top_cnt; i > 0 && lock_stat_more (l, top[i - 1]); i--)
+        if (i < max)
+          top[i] = top[i - 1];
+      if (i < max)
+        {
+          top[i] = l;
+          if (top_cnt < max)
+            top_cnt++;
+        }
+    }
+
+  printf ("Locks: %zu registered, top %d by contention:\n", lock_cnt, top_cnt);
+  printf ("  %-16s %9s %9s %9s %8s %8s\n",
+          "name", "acquired", "contended", "wait", "max wait", "max hold");
+  for (i = 0; i < top_cnt; i++)
+    {
+      struct lock_stat *s = &top[i]->stat;
+      printf ("  %-16s %9u %9u %9lld %8lld %8lld\n", top[i]->name,
+              s->acquisitions, s->contended, s->wait_ticks,
+              s->max_wait, s->max_hold);
+    }
+}
 
-/* One semaphore in a list. */
+/* One semaphore in a condition's waiters. */
 struct semaphore_elem 
   {
-    struct list_elem elem;              /* List element. */
+    struct pqueue_elem elem;            /* Condition waiters element. */
     struct semaphore semaphore;         /* This semaphore. */
+    struct thread *thread;              /* Thread waiting on it. */
   };
 
 /* Initializes condition variable COND.  A condition variable
@@ -275,7 +434,7 @@ cond_init (struct condition *cond)
 {
   ASSERT (cond != NULL);
 
-  list_init (&cond->waiters);
+  pqueue_init (&cond->waiters, cond_cmp, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -302,6 +461,8 @@ void
 cond_wait (struct condition *cond, struct lock *lock) 
 {
   struct semaphore_elem waiter;
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
 
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
@@ -309,7 +470,13 @@ cond_wait (struct condition *cond, struct lock *lock)
   ASSERT (lock_held_by_current_thread (lock));
   
   sema_init (&waiter.semaphore, 0);
-  list_push_back(&cond->waiters, &waiter.elem);
+  waiter.thread = cur;
+  // Donations may move us in COND's waiters, so say where we are
+  old_level = intr_disable ();
+  cur->cond_queue = &cond->waiters;
+  cur->cond_elem = &waiter.elem;
+  pqueue_push (&cond->waiters, &waiter.elem);
+  intr_set_level (old_level);
   lock_release (lock);
   sema_down (&waiter.semaphore);
   lock_acquire (lock);
@@ -330,13 +497,16 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED)
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
-  if (!list_empty (&cond->waiters)) 
+  if (!pqueue_empty (&cond->waiters)) 
   {
-    // Earlier we were removing the first elemtn from list
-    // now remove the element with max priority
-    struct list_elem *m = list_max (&cond->waiters, cond_cmp, NULL);
-    list_remove (m);
-    sema_up (&(list_entry (m, struct semaphore_elem, elem)->semaphore));
+    // Wake the waiter with max priority, which is first in line
+    enum intr_level old_level = intr_disable ();
+    struct semaphore_elem *w = pqueue_entry (pqueue_pop_max (&cond->waiters),
+                                             struct semaphore_elem, elem);
+    w->thread->cond_queue = NULL;
+    w->thread->cond_elem = NULL;
+    intr_set_level (old_level);
+    sema_up (&w->semaphore);
   }
 }
 
@@ -352,17 +522,145 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
 
-  while (!list_empty (&cond->waiters))
+  while (!pqueue_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
 
+/* Initializes RWLOCK.  Any number of readers may hold an rwlock
+   at once, or else a single writer.
+
+   Writers have preference: once a writer is waiting, readers
+   that arrive later wait until it is done.  This comes from
+   making readers pass through WRITE_LOCK on their way in, which
+   a writer holds while it waits for the readers already inside
+   to leave.  Priority donation is handled for both sides: threads
+   waiting to enter donate to the writer through WRITE_LOCK like
+   any other lock waiters, and a writer waiting for readers to
+   leave donates to each of them. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->write_lock);
+  rw->readers = 0;
+  list_init (&rw->reader_holds);
+  rw->draining = false;
+  sema_init (&rw->drained, 0);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   is waiting for it.  The current thread must not already hold
+   RW, and may hold at most RW_HOLD_MAX rwlocks for reading.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_read_acquire (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  struct rw_hold *h;
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+
+  for (h = cur->rw_holds; h < cur->rw_holds + RW_HOLD_MAX; h++)
+    if (h->rwlock == NULL)
+      break;
+  ASSERT (h < cur->rw_holds + RW_HOLD_MAX);
+
+  lock_acquire (&rw->write_lock);
+  old_level = intr_disable ();
+  rw->readers++;
+  h->rwlock = rw;
+  h->thread = cur;
+  list_push_back (&rw->reader_holds, &h->elem);
+  intr_set_level (old_level);
+  lock_release (&rw->write_lock);
+}
+
+/* Releases RW, which the current thread must hold for reading. */
+void
+rw_read_release (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  struct rw_hold *h;
+  enum intr_level old_level;
+  bool last;
+
+  ASSERT (rw != NULL);
+
+  for (h = cur->rw_holds; h < cur->rw_holds + RW_HOLD_MAX; h++)
+    if (h->rwlock == rw)
+      break;
+  ASSERT (h < cur->rw_holds + RW_HOLD_MAX);
+
+  old_level = intr_disable ();
+  list_remove (&h->elem);
+  h->rwlock = NULL;
+  last = --rw->readers == 0 && rw->draining;
+  // Give back whatever a waiting writer donated to us
+  if (!thread_mlfqs)
+    thread_recompute_priority (cur);
+  intr_set_level (old_level);
+
+  if (last)
+    sema_up (&rw->drained);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it for reading or writing.  The current thread must not
+   already hold RW.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rw_write_acquire (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+
+  /* Keeps out new readers and writers from here on. */
+  lock_acquire (&rw->write_lock);
+
+  old_level = intr_disable ();
+  while (rw->readers > 0)
+  {
+    rw->draining = true;
+    if (!thread_mlfqs)
+    {
+      struct list_elem *e;
+      for (e = list_begin (&rw->reader_holds);
+           e != list_end (&rw->reader_holds); e = list_next (e))
+        thread_donate_priority (list_entry (e, struct rw_hold, elem)->thread,
+                                cur->eff_priority);
+    }
+    sema_down (&rw->drained);
+  }
+  rw->draining = false;
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void
+rw_write_release (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_release (&rw->write_lock);
+}
+
 /************************************ T02 ********************************/
 // Comparing effective priority of threads 
 bool
-priority_sema (const struct list_elem *a, const struct list_elem *b,void *aux UNUSED)
+priority_sema (const struct pqueue_elem *a, const struct pqueue_elem *b,void *aux UNUSED)
 {
-  struct thread *ta = list_entry (a, struct thread, elem);
-  struct thread *tb = list_entry (b, struct thread, elem);
+  struct thread *ta = pqueue_entry (a, struct thread, wait_elem);
+  struct thread *tb = pqueue_entry (b, struct thread, wait_elem);
 
   if(thread_mlfqs!=true)
     return thread_get_effective_priority (ta) < thread_get_effective_priority (tb);
@@ -372,21 +670,12 @@ priority_sema (const struct list_elem *a, const struct list_elem *b,void *aux UN
 
 /************************************ T02 ********************************/
 // Comparing effective priority of threads
-// semaphore element-> thread element->then compare the priority
-// First find the semaphore element
-// From semaphore element extract the thread list waiting on that semaphore
-// Then extract the thread from its list 
+// semaphore element-> waiting thread->then compare the priority
 bool
-cond_cmp (struct list_elem *a, struct list_elem *b, void *aux UNUSED)
+cond_cmp (const struct pqueue_elem *a, const struct pqueue_elem *b, void *aux UNUSED)
 {
-  struct semaphore_elem *sema_list_a = list_entry (a, struct semaphore_elem, elem);
-  struct semaphore_elem *sema_list_b = list_entry (b, struct semaphore_elem, elem);
-
-  struct list_elem *thread_list_a = list_front (&(sema_list_a->semaphore.waiters));
-  struct list_elem *thread_list_b = list_front (&(sema_list_b->semaphore.waiters));
-
-  struct thread *thread_a = list_entry (thread_list_a, struct thread, elem);
-  struct thread *thread_b = list_entry (thread_list_b, struct thread, elem);
+  struct thread *thread_a = pqueue_entry (a, struct semaphore_elem, elem)->thread;
+  struct thread *thread_b = pqueue_entry (b, struct semaphore_elem, elem)->thread;
 
    if(thread_mlfqs!=true)
       return thread_get_effective_priority (thread_a) < thread_get_effective_priority (thread_b);
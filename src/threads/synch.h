@@ -2,13 +2,15 @@
 #define THREADS_SYNCH_H
 
 #include <list.h>
+#include <pqueue.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore 
   {
     unsigned value;             /* Current value. */
-    struct list waiters;        /* List of waiting threads. */
+    struct pqueue waiters;      /* Waiting threads, by priority. */
   };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -17,24 +19,45 @@ bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
+/* Contention statistics for a lock, kept only when
+   lock_stat_top is nonzero. */
+struct lock_stat
+  {
+    unsigned acquisitions;      /* Times acquired. */
+    unsigned contended;         /* Times acquired after waiting. */
+    int64_t wait_ticks;         /* Total ticks spent waiting. */
+    int64_t max_wait;           /* Longest wait, in ticks. */
+    int64_t max_hold;           /* Longest hold, in ticks. */
+    int64_t acquired_at;        /* When the holder acquired it. */
+  };
+
 /* Lock. */
 struct lock 
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
     struct list_elem locks_acquired_elem ;  /* Storing locks_acquired list elem */
+    const char *name;           /* Name, if registered, else NULL. */
+    struct lock *next_named;    /* Next lock in the registry. */
+    struct lock_stat stat;      /* Contention statistics. */
   };
 
+/* Number of most contended locks to print at shutdown; 0 turns
+   statistics off. */
+extern int lock_stat_top;
+
 void lock_init (struct lock *);
+void lock_init_named (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+void lock_print_stats (void);
 
 /* Condition variable. */
 struct condition 
   {
-    struct list waiters;        /* List of waiting threads. */
+    struct pqueue waiters;      /* Waiting semaphore_elems, by priority. */
   };
 
 void cond_init (struct condition *);
@@ -42,6 +65,33 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock. */
+struct rwlock
+  {
+    struct lock write_lock;     /* Held by the writer, if any. */
+    unsigned readers;           /* Number of active readers. */
+    struct list reader_holds;   /* struct rw_hold of each reader. */
+    bool draining;              /* Writer waiting for readers to leave? */
+    struct semaphore drained;   /* Upped when the last reader leaves. */
+  };
+
+/* A thread's hold on an rwlock as a reader.  Each thread has
+   RW_HOLD_MAX of these, so it can read that many rwlocks at
+   once. */
+#define RW_HOLD_MAX 4
+struct rw_hold
+  {
+    struct list_elem elem;      /* Element in rwlock's reader_holds. */
+    struct rwlock *rwlock;      /* Lock being read, or NULL if free. */
+    struct thread *thread;      /* Reading thread. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rw_read_acquire (struct rwlock *);
+void rw_read_release (struct rwlock *);
+void rw_write_acquire (struct rwlock *);
+void rw_write_release (struct rwlock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
@@ -52,5 +102,5 @@ void cond_broadcast (struct condition *, struct lock *);
 #endif /* threads/synch.h */
 
 /*******************T02********************/
-bool priority_sema (const struct list_elem *, const struct list_elem *,void *);
-bool cond_cmp (struct list_elem *, struct list_elem *, void *) ;
+bool priority_sema (const struct pqueue_elem *, const struct pqueue_elem *,void *);
+bool cond_cmp (const struct pqueue_elem *, const struct pqueue_elem *, void *) ;
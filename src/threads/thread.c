@@ -1,4 +1,4 @@
-#include "../lib/integer_arithmetic.h"
+#include "threads/integer_arithmetic.h"
 #include "threads/thread.h"
 #include <debug.h>
 #include <stddef.h>
@@ -18,26 +18,22 @@
 #endif
 
 
-/**** T02 Task 1+2 *****/
-/* List of blocked processes.  Processes are added to this list
-   when want to wait for some specified number of timer ticks and
-   removed when their wait time elapses. */
-static struct list sleepers_list;
-
-/* Stores the next wake up tick time. */
-static int64_t next_wakeup_at;
-
-
-
 
 /* Random value for struct thread's `magic' member.
    Used to detect stack overflow.  See the big comment at the top
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Number of distinct thread priorities. */
+#define PRI_CNT (PRI_MAX - PRI_MIN + 1)
+
+/* Run queue.  Processes in THREAD_READY state, that is, processes
+   that are ready to run but not actually running, are kept in one
+   FIFO list per priority.  Bit P of ready_bitmap is set if and
+   only if ready_queues[P] is nonempty, so the highest-priority
+   ready thread is found with a find-first-set plus a list pop. */
+static struct list ready_queues[PRI_CNT];
+static uint64_t ready_bitmap;
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
@@ -47,19 +43,88 @@ static struct list all_list;
 static struct thread *idle_thread;
 
 /** T03 **/
-/*** Manager Thread ***/
-static struct thread *manager_thread;
-/*** BSD scheduler thread ***/
-static struct thread *bsd_scheduler_thread; 
-
 static int load_avg;            /* # of ready and running threads. */
 
-/* Indicates whether 100 Ticks has elapsed and similariy for slice four ticks have elapsed or not .*/
-static bool schedule_sec;
-static bool schedule_slice;
+/* Number of threads in the run queue, maintained as threads are
+   queued and dequeued so that load_avg never scans it. */
+static int ready_cnt;
+
+/* The per-second recent_cpu decay is applied lazily.  Each second
+   the decay coefficient is recorded here and mlfqs_seconds
+   advances; a thread catches up on the seconds it missed, using
+   the recorded coefficients, the next time it is examined.  Seconds
+   older than the history reuse its oldest coefficient. */
+#define DECAY_HISTORY 64
+static int decay_history[DECAY_HISTORY];
+static int mlfqs_seconds;
+
+static void mlfqs_second (void);
+static int mlfqs_priority (struct thread *);
+
+/* Fair-share scheduler.  Each thread's vruntime goes up by
+   FAIR_TICK * NICE_0_WEIGHT / weight every tick it runs, where
+   weight comes from its nice value, and the ready thread with the
+   smallest vruntime runs next.  In this mode ready threads are
+   kept in a leftist min-heap rooted at fair_root instead of in
+   ready_queues[].
+
+   fair_min_vruntime follows the smallest vruntime among the
+   running and ready threads, but never goes backward.  A thread
+   that wakes up is placed no further back than FAIR_SLEEPER_CREDIT
+   behind it, so that a long sleep does not earn it the CPU for as
+   long afterward. */
+#define FAIR_TICK 1024                  /* vruntime of one nice 0 tick. */
+#define FAIR_NICE_0_WEIGHT 1024
+#define FAIR_SLEEPER_CREDIT (TIME_SLICE * FAIR_TICK / 2)
+#define FAIR_WAKEUP_GRANULARITY FAIR_TICK
+
+/* Weight of nice NICE_MIN through NICE_MAX.  Each step is about
+   1.25x, so a thread gets roughly 10% more CPU than one a nice
+   level above. */
+static const int fair_weights[NICE_MAX - NICE_MIN + 1] =
+  {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */  9548,  7620,  6100,  4904,  3906,
+    /*  -5 */  3121,  2501,  1991,  1586,  1277,
+    /*   0 */  1024,   820,   655,   526,   423,
+    /*   5 */   335,   272,   215,   172,   137,
+    /*  10 */   110,    87,    70,    56,    45,
+    /*  15 */    36,    29,    23,    18,    15,
+    /*  20 */    12,
+  };
+
+static struct thread *fair_root;
+static int64_t fair_min_vruntime;
+
+static struct thread *fair_merge (struct thread *, struct thread *);
+static void fair_update_min (struct thread *);
+
+/* Earliest-deadline-first real-time class, which runs ahead of
+   whichever scheduler is selected for everyone else.  A thread
+   joins it with thread_set_realtime(PERIOD, BUDGET), after which
+   it may run for BUDGET ticks in each PERIOD.  Ready real-time
+   threads with budget left wait in rt_ready_list, earliest
+   deadline first.  One that uses up its budget is "throttled":
+   it is left out of every run queue until its next period starts.
+   A thread's period ends, and the next one starts, when its
+   rt_timer fires; if it has not reached
+   thread_wait_next_period() by then, it has missed its deadline.
+
+   Admission control keeps the sum of budget/period over all
+   real-time threads, in units of RT_UTIL_SCALE, no greater than
+   one whole CPU, which is the condition for EDF to meet every
+   deadline. */
+static struct list rt_ready_list;
+static int rt_utilization;
+static long long rt_periods;    /* # of real-time periods ended. */
+static long long rt_missed;     /* # of those with a deadline missed. */
 
-/*** Function of BSD scheduler ***/
-static void bsd_scheduler (void);
+static inline bool rt_runnable (struct thread *);
+static bool rt_deadline_less (const struct list_elem *,
+                              const struct list_elem *, void *aux);
+static void rt_period_end (void *t_);
+static void rt_leave (struct thread *);
 
 
 
@@ -82,6 +147,19 @@ static long long idle_ticks;    /* # of timer ticks spent idle. */
 static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
 static long long user_ticks;    /* # of timer ticks in user programs. */
 
+/* Wakeup latency: the time from thread_unblock() until the thread
+   runs, measured in TSC cycles if the CPU has a time-stamp
+   counter, otherwise in timer ticks.  latency_hist[P][B] counts
+   wakeups of threads running at priority P whose latency was in
+   [2**B, 2**(B+1)), with everything shorter in bucket 0 and
+   everything longer in the last. */
+#define LATENCY_BUCKETS 48
+static unsigned latency_hist[PRI_CNT][LATENCY_BUCKETS];
+static bool have_tsc;           /* Measuring in TSC cycles? */
+
+static void latency_record (struct thread *);
+static void print_latency_stats (void);
+
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
@@ -91,6 +169,10 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use the fair-share scheduler.
+   Controlled by kernel command-line option "-fair". */
+bool thread_fair;
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -102,6 +184,10 @@ static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static int ready_queue_priority (struct thread *);
+static void ready_queue_push (struct thread *, int priority);
+static void ready_queue_remove (struct thread *);
+static int ready_queue_highest (void);
 
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
@@ -116,16 +202,28 @@ static tid_t allocate_tid (void);
 void
 thread_init (void) 
 {
+  int i;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
-  lock_init (&tid_lock);
-  list_init (&ready_list);
+  lock_init_named (&tid_lock, "tid_lock");
+  for (i = 0; i < PRI_CNT; i++)
+    list_init (&ready_queues[i]);
+  ready_bitmap = 0;
+  list_init (&rt_ready_list);
   list_init (&all_list);
-  list_init (&sleepers_list);
-  next_wakeup_at = INT64_MAX;
   load_avg = 0;       
-  schedule_sec = false;   
-  schedule_slice = false;
+  ready_cnt = 0;
+  mlfqs_seconds = 0;
+  fair_root = NULL;
+  fair_min_vruntime = 0;
+
+  /* CPUID leaf 1 reports the time-stamp counter in EDX bit 4. */
+  {
+    uint32_t a = 1, b, c, d;
+    asm volatile ("cpuid" : "+a" (a), "=b" (b), "=c" (c), "=d" (d));
+    have_tsc = (d & (1u << 4)) != 0;
+  }
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
@@ -148,10 +246,8 @@ thread_start (void)
   /* Start preemptive thread scheduling. */
   intr_enable ();
 
-  /* Waits for idle thread to start and then create manager and bsd scheduler */
+  /* Wait for the idle thread to initialize idle_thread. */
   sema_down (&idle_started);
-  thread_create ("manager_thread", PRI_MAX, manager_wakeup, NULL);
-  thread_create ("bsd_scheduler", PRI_MAX, bsd_scheduler, NULL);
 }
 
 /* Called by the timer interrupt handler at each timer tick.
@@ -161,10 +257,9 @@ void
 thread_tick (void) 
 {
   struct thread *t = thread_current ();
-  // Increment rcent_cpu at every tick
-  t->recent_cpu = _ADD_INT (t->recent_cpu, 1);
 
   /* Update statistics. */
+  t->usage.run_ticks++;
   if (t == idle_thread)
     idle_ticks++;
 #ifdef USERPROG
@@ -174,33 +269,48 @@ thread_tick (void)
   else
     kernel_ticks++;
 
-
-  long long ticks = timer_ticks ();
-  if (ticks >= next_wakeup_at && manager_thread->status==THREAD_BLOCKED)
+  /* Enforce the real-time budget. */
+  if (t->rt_period != 0 && --t->rt_remaining <= 0)
   {
-    thread_unblock (manager_thread);
+    t->rt_throttled = true;
+    intr_yield_on_return ();
   }
 
-  /*** Makes schedule_sec true after every 100 ticks ***/
-  if (ticks % TIMER_FREQ == 0)
+  /* 4.4BSD bookkeeping is done right here, and only for the
+     running thread, except once per second. */
+  if (thread_mlfqs)
   {
-    schedule_sec = true;
-  }
+    int64_t ticks = timer_ticks ();
 
-  /* Enforce preemption. */
-  if (++thread_ticks >= TIME_SLICE)
-  {
-    schedule_slice = true;
-    intr_yield_on_return ();
+    // Increment recent_cpu at every tick
+    if (t != idle_thread)
+      t->recent_cpu = _ADD_INT (t->recent_cpu, 1);
+
+    if (ticks % TIMER_FREQ == 0)
+      mlfqs_second ();
+
+    // Only the running thread's recent_cpu went up since the last
+    // recalculation, so it is the only priority that can drop
+    if (ticks % TIME_SLICE == 0 && t != idle_thread)
+    {
+      thread_update_priority (t);
+      if (ready_queue_highest () > t->priority)
+        intr_yield_on_return ();
+    }
   }
 
-  /*** schedule_sec for Task 2 and schedule_slice for Task 3 ***/
-  if ((schedule_sec || schedule_slice) && bsd_scheduler_thread->status == THREAD_BLOCKED && thread_mlfqs)
+  /* Charge the running thread for this tick, in proportion to the
+     inverse of its weight. */
+  if (thread_fair && t != idle_thread)
   {
-    thread_unblock (bsd_scheduler_thread);
-    intr_yield_on_return ();
+    t->vruntime += FAIR_TICK * FAIR_NICE_0_WEIGHT
+                   / fair_weights[t->nice - NICE_MIN];
+    fair_update_min (t);
   }
 
+  /* Enforce preemption. */
+  if (++thread_ticks >= TIME_SLICE)
+    intr_yield_on_return ();
 }
 
 /* Prints thread statistics. */
@@ -209,6 +319,141 @@ thread_print_stats (void)
 {
   printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
           idle_ticks, kernel_ticks, user_ticks);
+  if (rt_periods > 0)
+    printf ("Thread: %lld real-time periods, %lld deadlines missed\n",
+            rt_periods, rt_missed);
+  print_latency_stats ();
+}
+
+/* Prints the wakeup latency histogram of each priority that has
+   seen any wakeups, as "bucket:count" pairs, where bucket B holds
+   latencies of at least 2**B. */
+static void
+print_latency_stats (void) 
+{
+  int pri, b;
+
+  for (pri = PRI_MAX; pri >= PRI_MIN; pri--)
+    {
+      bool any = false;
+      for (b = 0; b < LATENCY_BUCKETS; b++)
+        if (latency_hist[pri][b] != 0)
+          {
+            if (!any)
+              printf ("Thread: priority %d wakeup latency (log2 %s):",
+                      pri, thread_clock_unit ());
+            any = true;
+            printf (" %d:%u", b, latency_hist[pri][b]);
+          }
+      if (any)
+        printf ("\n");
+    }
+}
+
+/* Clears the wakeup latency histograms. */
+void
+thread_reset_latency (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  memset (latency_hist, 0, sizeof latency_hist);
+  intr_set_level (old_level);
+}
+
+/* Returns the number of wakeups recorded in the latency histogram
+   for PRIORITY since it was last cleared. */
+unsigned
+thread_latency_count (int priority) 
+{
+  enum intr_level old_level;
+  unsigned cnt = 0;
+  int b;
+
+  ASSERT (priority >= PRI_MIN && priority <= PRI_MAX);
+
+  old_level = intr_disable ();
+  for (b = 0; b < LATENCY_BUCKETS; b++)
+    cnt += latency_hist[priority][b];
+  intr_set_level (old_level);
+  return cnt;
+}
+
+/* Returns the current time for latency measurement, in the units
+   named by thread_clock_unit(). */
+uint64_t
+thread_clock (void) 
+{
+  uint64_t tsc;
+
+  if (!have_tsc)
+    return timer_ticks ();
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Returns the name of thread_clock()'s units. */
+const char *
+thread_clock_unit (void) 
+{
+  return have_tsc ? "cycles" : "ticks";
+}
+
+/* Adds the latency of T's latest wakeup, if any, to the histogram
+   for the priority it is running at.  Interrupts must be off. */
+static void
+latency_record (struct thread *t) 
+{
+  uint64_t latency;
+  uint32_t hi, lo;
+  int b;
+
+  if (t->unblocked_at == 0)
+    return;
+  latency = thread_clock () - t->unblocked_at;
+  t->unblocked_at = 0;
+
+  /* Floor of log2, as two 32-bit halves to avoid libgcc. */
+  hi = latency >> 32;
+  lo = latency;
+  if (hi != 0)
+    b = 63 - __builtin_clz (hi);
+  else if (lo != 0)
+    b = 31 - __builtin_clz (lo);
+  else
+    b = 0;
+  if (b >= LATENCY_BUCKETS)
+    b = LATENCY_BUCKETS - 1;
+  latency_hist[ready_queue_priority (t)][b]++;
+}
+
+/* Prints each thread's scheduling statistics. */
+void
+thread_print_usage (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  struct list_elem *e;
+
+  for (e = list_begin (&all_list); e != list_end (&all_list);
+       e = list_next (e))
+    {
+      struct thread *t = list_entry (e, struct thread, allelem);
+      struct rusage *u = &t->usage;
+
+      printf ("Thread %d (%s): %lld run, %lld ready, %lld blocked ticks, "
+              "%d voluntary, %d involuntary switches, %d page faults\n",
+              t->tid, t->name, u->run_ticks, u->ready_ticks,
+              u->blocked_ticks, u->voluntary_switches,
+              u->involuntary_switches, u->page_faults);
+    }
+  intr_set_level (old_level);
+}
+
+/* Copies the running thread's scheduling statistics to USAGE. */
+void
+thread_get_rusage (struct rusage *usage) 
+{
+  enum intr_level old_level = intr_disable ();
+  *usage = thread_current ()->usage;
+  intr_set_level (old_level);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -235,6 +480,7 @@ thread_create (const char *name, int priority,
   struct switch_threads_frame *sf;
   tid_t tid;
   enum intr_level old_level;
+  bool preempt;
 
   ASSERT (function != NULL);
 
@@ -267,13 +513,13 @@ thread_create (const char *name, int priority,
   sf->eip = switch_entry;
   sf->ebp = 0;
 
-  intr_set_level (old_level);
-
-  /* Add to run queue. */
+  /* Add to run queue, and let the new thread run now if it
+     should run ahead of us. */
   thread_unblock (t);
-  
-  /* Bring next thread to cpu */
-  thread_yield ();
+  preempt = thread_should_preempt (t);
+  intr_set_level (old_level);
+  if (preempt)
+    thread_yield ();
 
   return tid;
 }
@@ -310,8 +556,19 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
-  // push the blocked thread into ready list and change the thread status 
-  list_push_back (&ready_list, &t->elem);
+  t->usage.blocked_ticks += timer_ticks () - t->state_since;
+  t->state_since = timer_ticks ();
+  t->unblocked_at = thread_clock ();
+  if (thread_mlfqs)
+  {
+    // Apply the decay it missed while blocked before queueing it
+    thread_update_recent_cpu (t);
+    thread_update_priority (t);
+  }
+  if (thread_fair && t->vruntime < fair_min_vruntime - FAIR_SLEEPER_CREDIT)
+    t->vruntime = fair_min_vruntime - FAIR_SLEEPER_CREDIT;
+  // push the blocked thread into its run queue and change the thread status 
+  ready_queue_push (t, ready_queue_priority (t));
   t->status = THREAD_READY;
   intr_set_level (old_level);
 }
@@ -361,6 +618,8 @@ thread_exit (void)
   process_exit ();
 #endif
 
+  rt_leave (thread_current ());
+
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
      when it call schedule_tail(). */
@@ -383,10 +642,10 @@ thread_yield (void)
 
   old_level = intr_disable ();
 
-  // Insert the running thread into ready list and then call scheduler
+  // Insert the running thread into its run queue and then call scheduler
   if (cur != idle_thread) 
   {    
-    list_push_back (&ready_list, &cur->elem);
+    ready_queue_push (cur, ready_queue_priority (cur));
   }
 
   cur->status = THREAD_READY;
@@ -429,6 +688,9 @@ idle (void *idle_started_ UNUSED)
 
   for (;;) 
     {
+      /* Zero free pages while there is nothing else to do. */
+      palloc_zero_idle ();
+
       /* Let someone else run. */
       intr_disable ();
       thread_block ();
@@ -442,7 +704,11 @@ idle (void *idle_started_ UNUSED)
          one to occur, wasting as much as one clock tick worth of
          time.
          See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-         7.11.1 "HLT Instruction". */
+         7.11.1 "HLT Instruction".
+
+         In tickless mode the timer may skip ticks while we are
+         halted; the interrupt that wakes us catches it back up. */
+      timer_idle_enter ();
       asm volatile ("sti; hlt" : : : "memory");
     }
 }
@@ -494,9 +760,8 @@ init_thread (struct thread *t, const char *name, int priority)
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
+  t->eff_priority = priority;
   t->old_priority = priority;
-  t->no_yield = false;
-  t->wakeup_at = -1;
 
   if (t == initial_thread)
     t->nice= 0;
@@ -504,6 +769,9 @@ init_thread (struct thread *t, const char *name, int priority)
     t->nice = thread_current ()->nice;
 
   t->recent_cpu = 0;
+  t->recent_cpu_epoch = mlfqs_seconds;
+  t->vruntime = fair_min_vruntime;
+  t->state_since = timer_ticks ();
   /** T02 **/
   list_init (&t->locks_acquired);
 
@@ -530,10 +798,12 @@ init_thread (struct thread *t, const char *name, int priority)
     t->parent = NULL;
   }  
 
+#ifdef VM
   if (t != initial_thread)
   {
     supp_page_table_init (&t->supp_page_table);
   }  
+#endif
   
   list_init (&t->children);
   sema_init (&t->sema_ready, 0);
@@ -564,24 +834,215 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list))
+  int pri;
+  struct thread *t;
+
+  if (!list_empty (&rt_ready_list))
+    {
+      t = list_entry (list_pop_front (&rt_ready_list), struct thread, elem);
+      ready_cnt--;
+      return t;
+    }
+
+  if (thread_fair)
+    {
+      if (fair_root == NULL)
+        return idle_thread;
+
+      /* Remove the thread with the least vruntime. */
+      t = fair_root;
+      fair_root = fair_merge (t->fair_left, t->fair_right);
+      ready_cnt--;
+      fair_update_min (t);
+      return t;
+    }
+
+  pri = ready_queue_highest ();
+  if (pri < 0)
     return idle_thread;
-  /* Remove the maximum priority thread */
-  else
-  {
-    struct list_elem *e;
-    if(thread_mlfqs==true)
+
+  /* Remove the oldest thread of the highest nonempty priority. */
+  t = list_entry (list_front (&ready_queues[pri]), struct thread, elem);
+  ready_queue_remove (t);
+  return t;
+}
+
+/* Returns the priority whose run queue thread T belongs in. */
+static int
+ready_queue_priority (struct thread *t)
+{
+  if (thread_mlfqs)
+    return t->priority;
+  return t->eff_priority;
+}
+
+/* Appends T to the run queue for PRIORITY and marks that queue
+   nonempty.  In fair-share mode, adds T to the heap instead.  A
+   real-time thread goes in rt_ready_list, or nowhere if it is
+   throttled.  Interrupts must be off. */
+static void
+ready_queue_push (struct thread *t, int priority)
+{
+  ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+  t->ready_pri = priority;
+  if (t->rt_period != 0)
     {
-       e = list_max (&ready_list, priority_cmp_mlfqs, NULL);
+      if (!t->rt_throttled)
+        {
+          list_insert_ordered (&rt_ready_list, &t->elem,
+                               rt_deadline_less, NULL);
+          ready_cnt++;
+        }
+      return;
     }
-    else
+  if (thread_fair)
     {
-      e = list_max (&ready_list, priority_cmp, NULL);
+      t->fair_left = t->fair_right = NULL;
+      t->fair_rank = 1;
+      fair_root = fair_merge (fair_root, t);
+      ready_cnt++;
+      return;
     }
-    list_remove (e);
-    return list_entry (e, struct thread, elem);
-  }
+
+  list_push_back (&ready_queues[priority], &t->elem);
+  ready_bitmap |= (uint64_t) 1 << priority;
+  ready_cnt++;
 }
+
+/* Removes T from its run queue, clearing the queue's bit if it
+   became empty.  Interrupts must be off. */
+static void
+ready_queue_remove (struct thread *t)
+{
+  list_remove (&t->elem);
+  if (list_empty (&ready_queues[t->ready_pri]))
+    ready_bitmap &= ~((uint64_t) 1 << t->ready_pri);
+  ready_cnt--;
+}
+
+/* Returns the highest priority with a nonempty run queue, or -1
+   if no thread is ready.  The bitmap is scanned as two 32-bit
+   halves so that no 64-bit helper from libgcc is needed. */
+static int
+ready_queue_highest (void)
+{
+  uint32_t hi = ready_bitmap >> 32;
+  uint32_t lo = ready_bitmap;
+
+  if (hi != 0)
+    return 63 - __builtin_clz (hi);
+  if (lo != 0)
+    return 31 - __builtin_clz (lo);
+  return -1;
+}
+
+/* Moves ready thread T to the run queue matching its current
+   priority, if that changed since it was queued.  It goes to the
+   back of its new queue, like any other newly ready thread.
+   If T is waiting on a semaphore or condition variable, moves
+   it to its new place among the waiters instead, keeping its
+   place among waiters of equal priority.  Interrupts must be
+   off. */
+void
+thread_requeue (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t->wait_queue != NULL)
+    pqueue_update (t->wait_queue, &t->wait_elem);
+  if (t->cond_queue != NULL)
+    pqueue_update (t->cond_queue, t->cond_elem);
+
+  /* Neither the fair-share heap nor the real-time class is
+     ordered by priority. */
+  if (thread_fair || t->rt_period != 0)
+    return;
+
+  if (t->status == THREAD_READY)
+    {
+      int pri = ready_queue_priority (t);
+      if (pri != t->ready_pri)
+        {
+          ready_queue_remove (t);
+          ready_queue_push (t, pri);
+        }
+    }
+}
+
+/* Returns true if ready thread T ought to run in place of the
+   running thread, that is, if it would be scheduled ahead of it.
+   May be called from an interrupt handler, which can then use
+   intr_yield_on_return(). */
+bool
+thread_should_preempt (struct thread *t)
+{
+  struct thread *cur = thread_current ();
+
+  if (rt_runnable (t) || rt_runnable (cur))
+    return cur == idle_thread
+           || (rt_runnable (t)
+               && (!rt_runnable (cur) || t->rt_deadline < cur->rt_deadline));
+  if (thread_fair)
+    return cur == idle_thread
+           || t->vruntime + FAIR_WAKEUP_GRANULARITY < cur->vruntime;
+  return cur == idle_thread
+         || ready_queue_priority (t) > ready_queue_priority (cur);
+}
+
+/* Returns the rank of leftist heap T, 0 if T is empty. */
+static inline int
+fair_rank (struct thread *t)
+{
+  return t != NULL ? t->fair_rank : 0;
+}
+
+/* Merges leftist heaps A and B and returns the result.  Ties go
+   to A, so a thread merged into the heap goes after those already
+   there with the same vruntime.  The recursion follows only the
+   right spines, which are at most log2(n + 1) long.  Interrupts
+   must be off. */
+static struct thread *
+fair_merge (struct thread *a, struct thread *b)
+{
+  struct thread *t;
+
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+  if (b->vruntime < a->vruntime)
+    {
+      t = a;
+      a = b;
+      b = t;
+    }
+
+  a->fair_right = fair_merge (a->fair_right, b);
+  if (fair_rank (a->fair_left) < fair_rank (a->fair_right))
+    {
+      t = a->fair_left;
+      a->fair_left = a->fair_right;
+      a->fair_right = t;
+    }
+  a->fair_rank = fair_rank (a->fair_right) + 1;
+  return a;
+}
+
+/* Advances fair_min_vruntime to the lesser of the vruntimes of T,
+   which is running or about to run, and the first ready thread.
+   Interrupts must be off. */
+static void
+fair_update_min (struct thread *t)
+{
+  int64_t min = t->vruntime;
+
+  if (fair_root != NULL && fair_root->vruntime < min)
+    min = fair_root->vruntime;
+  if (min > fair_min_vruntime)
+    fair_min_vruntime = min;
+}
+
 /* Completes a thread switch by activating the new thread's page
    tables, and, if the previous thread is dying, destroying it.
    At this function's invocation, we just switched from thread
@@ -603,7 +1064,10 @@ schedule_tail (struct thread *prev)
   ASSERT (intr_get_level () == INTR_OFF);
 
   /* Mark us as running. */
+  if (cur->status == THREAD_READY)
+    cur->usage.ready_ticks += timer_ticks () - cur->state_since;
   cur->status = THREAD_RUNNING;
+  latency_record (cur);
 
   /* Start new time slice. */
   thread_ticks = 0;
@@ -642,8 +1106,17 @@ schedule (void)
   ASSERT (cur->status != THREAD_RUNNING);
   ASSERT (is_thread (next));
 
+  cur->state_since = timer_ticks ();
   if (cur != next)
-    prev = switch_threads (cur, next);
+    {
+      /* Count the switch.  Like getrusage(2), a switch is
+         voluntary if CUR gave up the CPU by blocking. */
+      if (cur->status == THREAD_BLOCKED)
+        cur->usage.voluntary_switches++;
+      else if (cur->status == THREAD_READY)
+        cur->usage.involuntary_switches++;
+      prev = switch_threads (cur, next);
+    }
   schedule_tail (prev); 
 }
 
@@ -687,105 +1160,6 @@ thread_priority_restore()
   thread_set_priority(t->old_priority);
 }
 
-/* Comparator used for sorting ready_list according to the priority in descending order. */
-bool
-priority_cmp_mlfqs (const struct list_elem *list_elem_1, const struct list_elem *list_elem_2,
-        void *aux UNUSED)
-{
-  struct thread *thread_elem_1 = list_entry (list_elem_1, struct thread, elem);
-  struct thread *thread_elem_2 = list_entry (list_elem_2, struct thread, elem);
-  return thread_elem_1->priority < thread_elem_2->priority ;
-}
-
-/* Comparator used for sorting ready_list according to the effective priority in descending order. */
-bool
-priority_cmp (const struct list_elem *list_elem_1, const struct list_elem *list_elem_2,
-        void *aux UNUSED)
-{
-  struct thread *thread_elem_1 = list_entry (list_elem_1, struct thread, elem);
-  struct thread *thread_elem_2 = list_entry (list_elem_2, struct thread, elem);
-  return thread_get_effective_priority (thread_elem_1) < thread_get_effective_priority (thread_elem_2);
-}
-
-
-/** T01 Task 2 **/
-/* 
-  Get current thread
-  Disable interupts (to prevent pre-emption of current thread)
-  Change the next wakeup time and insert the current thread into the sleepers list
-*/
-void
-thread_block_till (int64_t wakeup_at)
-{
-  struct thread *current = thread_current ();
-  enum intr_level old_level;
-  old_level = intr_disable ();
-  current->wakeup_at = wakeup_at;
-  if (wakeup_at < next_wakeup_at)
-    next_wakeup_at = wakeup_at;
-  list_insert_ordered (&sleepers_list, &current->sleepers_elem, before, NULL);
-  thread_block ();
-  intr_set_level (old_level);
-}
-
-/* Comparator used for sorting sleepers_list according to
-   their wakeup time. */
-bool
-before (const struct list_elem *list_elem_1, const struct list_elem *list_elem_2,
-        void *aux UNUSED)
-{
-  struct thread *thread_elem_1 = list_entry (list_elem_1, struct thread, sleepers_elem);
-  struct thread *thread_elem_2 = list_entry (list_elem_2, struct thread, sleepers_elem);
-  return thread_elem_1->wakeup_at < thread_elem_2->wakeup_at;
-}
-
-
-
-
-
-
-/** T01 Task 3 **/
-
-/* Unblocks the first thread of sleepers_list if its wakeup time has arrived
-   and updates the next_wakeup_at in accordance to the first element in 
-   sleepers_list. */
-void
-thread_set_next_wakeup ()
-{
-  enum intr_level old_level;
-  old_level = intr_disable ();
-
-  if (list_empty (&sleepers_list))
-    next_wakeup_at = INT64_MAX;
-  else
-  {
-    struct list_elem *front = list_front (&sleepers_list);
-    struct thread *t = list_entry (front, struct thread, sleepers_elem);
-    if (t->wakeup_at <= next_wakeup_at && timer_ticks () >= next_wakeup_at)
-    {
-      list_pop_front (&sleepers_list);
-      thread_unblock (t);
-
-      if (list_empty (&sleepers_list))
-      {
-        next_wakeup_at = INT64_MAX;
-      }
-      else
-      {
-        front = list_front (&sleepers_list);
-        t = list_entry (front, struct thread, sleepers_elem);
-        next_wakeup_at = t->wakeup_at;
-      }
-    }
-    else
-      next_wakeup_at = t->wakeup_at;
-  }
-
-  intr_set_level (old_level);
-}
-
-
-
 
 /** T02 Task 01 **/
 
@@ -794,11 +1168,15 @@ void
 thread_set_priority (int new_priority) 
 {
   struct thread *t = thread_current ();
-  int cur_priority = t->priority;
+  int cur_priority = t->eff_priority;
 
-  /* If the thread's new priority is lower than current priority then yield()*/
+  /* Donations received through held locks still apply on top of
+     the new base priority. */
   t->priority = new_priority;
-  if(new_priority < cur_priority)
+  thread_recompute_priority (t);
+
+  /* If the thread's new priority is lower than current priority then yield()*/
+  if(t->eff_priority < cur_priority)
     thread_yield ();
 }
 
@@ -819,110 +1197,131 @@ thread_get_priority (void)
 
 /** T02 Task 05 **/
 
-/* Returns effective priroty of the thread (after donation). */
+/* Returns effective priroty of the thread (after donation).
+   This is the value cached by the donation code below, so it is
+   cheap enough to call from comparators. */
 int
 thread_get_effective_priority (struct thread *t)
 {
-  if(!list_empty (&t->locks_acquired))
+  return t->eff_priority;
+}
+
+/* Recomputes T's cached effective priority from scratch: the
+   maximum of its own priority, the effective priorities of every
+   thread waiting on a lock T holds, and those of writers waiting
+   for T to stop reading an rwlock.  Used when T loses a
+   donation (lock release) or changes its own priority, which are
+   the only times the cached value can go down. */
+void
+thread_recompute_priority (struct thread *t)
+{
+  int max_priority = t->priority;
+  struct list_elem *e;
+  int i;
+  enum intr_level old_level = intr_disable ();
+
+  for (e = list_begin (&t->locks_acquired); e != list_end (&t->locks_acquired);  e = list_next (e))
   {
-    int max_priority = t->priority;
-    struct list_elem *e ;
-    for (e = list_begin (&t->locks_acquired); e != list_end (&t->locks_acquired);  e = list_next (e))
-    {
-      struct lock *l = list_entry (e, struct lock, locks_acquired_elem);
-      struct list *waiters = &l->semaphore.waiters;
+    struct lock *l = list_entry (e, struct lock, locks_acquired_elem);
+    struct pqueue *waiters = &l->semaphore.waiters;
 
-      if(!list_empty (waiters))
+    // The first waiter has the highest priority
+    if (!pqueue_empty (waiters))
+    {
+      struct thread *h = pqueue_entry (pqueue_max (waiters), struct thread, wait_elem);
+      if(h->eff_priority > max_priority)
       {
-        struct list_elem *w ; 
-        for (w = list_begin (waiters); w != list_end (waiters); w = list_next (w))
-        {
-          struct thread *h = list_entry(w, struct thread, elem);
-          int ep = thread_get_effective_priority(h);
-          if(ep > max_priority)
-          {
-            max_priority = ep;
-          }
-        }
+        max_priority = h->eff_priority;
       }
     }
-    
-    return max_priority;
   }
-  else
+  for (i = 0; i < RW_HOLD_MAX; i++)
   {
-    return t->priority;
+    struct rwlock *rw = t->rw_holds[i].rwlock;
+    if (rw != NULL && rw->draining
+        && rw->write_lock.holder->eff_priority > max_priority)
+      max_priority = rw->write_lock.holder->eff_priority;
   }
+  t->eff_priority = max_priority;
+  thread_requeue (t);
+  intr_set_level (old_level);
 }
 
+/* Donates PRIORITY to T, the holder of a lock that a thread of
+   that effective priority is about to wait on.  The donation is
+   pushed up the chain of lock holders (T may itself be waiting on
+   a lock) until a holder already has at least PRIORITY or
+   DONATION_DEPTH_MAX holders have been visited.  Ready holders
+   are moved to their new run queue on the way.
+   Interrupts must be off. */
+void
+thread_donate_priority (struct thread *t, int priority)
+{
+  int depth;
 
-/** T03 Task 01 **/
+  ASSERT (intr_get_level () == INTR_OFF);
 
-/* Function to run in managerial_thread */
-void manager_wakeup(void)
-{
-  manager_thread=thread_current();
-  while(true)
+  for (depth = 0; t != NULL && depth < DONATION_DEPTH_MAX; depth++)
   {
-    enum intr_level old_level=intr_disable();
-    thread_block();
-    intr_set_level(old_level);
-    timer_wakeup();
+    if (t->eff_priority >= priority)
+      break;
+    t->eff_priority = priority;
+    thread_requeue (t);
+
+    if (t->waiting_lock == NULL)
+      break;
+    t = t->waiting_lock->holder;
   }
 }
 
-/* Function to wake up all sleepers with wakeing time less than current time 
-   And then finally change the next wakeup time*/
-void
-timer_wakeup (void)
-{
-  enum intr_level old_level;
-  old_level = intr_disable ();
-  int64_t i=next_wakeup_at;
-  while(!list_empty(&sleepers_list))
-  {
-    struct list_elem *front = list_front (&sleepers_list);
-    struct thread *t = list_entry (front, struct thread, sleepers_elem);
 
-    if (t->wakeup_at <= i)
-    {
-      list_pop_front (&sleepers_list);
-      thread_unblock (t);
-    }
-    else
-    {
-      next_wakeup_at = t->wakeup_at;
-      break;
-    }
-  }
-  if (list_empty (&sleepers_list))
-  {
-    next_wakeup_at = INT64_MAX;
-  }
+/** T03 Task 01 **/
 
-  intr_set_level (old_level);
-}
+/* Returns the priority of the given thread based on recent_cpu and nice value.
+   priority = PRI_MAX - (recent_cpu / 4) - (nice * 2),
+   clamped to a valid priority, which is also a valid run queue. */
+static int
+mlfqs_priority (struct thread *t)
+{
+  int aux = _ADD_INT (_DIVIDE_INT (t->recent_cpu, 4), 2*t->nice);
+  int priority = _TO_INT_ZERO (_INT_SUB (PRI_MAX, aux));
 
+  if (priority < PRI_MIN)
+    priority = PRI_MIN;
+  else if (priority > PRI_MAX)
+    priority = PRI_MAX;
+  return priority;
+}
 
-/* Updates priority of the given thread based on recent_cpu and nice value.
-   priority = PRI_MAX - (recent_cpu / 4) - (nice * 2). */
+/* Updates priority of the given thread based on recent_cpu and
+   nice value, moving it in the run queue if it is ready. */
 void
 thread_update_priority (struct thread *t)
 {
-  int aux = _ADD_INT (_DIVIDE_INT (t->recent_cpu, 4), 2*t->nice);
-  t->priority = _TO_INT_ZERO (_INT_SUB (PRI_MAX, aux));
-}
+  t->priority = mlfqs_priority (t);
 
+  if (t->status == THREAD_READY)
+    thread_requeue (t);
+}
 
-/* Updates recent_cpu value using:
-   recent_cpu = (2*load_avg )/(2*load_avg + 1) * recent_cpu + nice. */
+/* Brings T's recent_cpu up to date by applying, once for each
+   second since it was last examined,
+   recent_cpu = (2*load_avg )/(2*load_avg + 1) * recent_cpu + nice,
+   with the coefficient recorded for that second. */
 void
 thread_update_recent_cpu (struct thread *t)
 {
-  int double_load_avg = _MULTIPLY_INT (load_avg, 2);
-  int alpha = _DIVIDE (double_load_avg, _ADD_INT (double_load_avg, 1));
-  int aux = _MULTIPLY (alpha, t->recent_cpu);
-  t->recent_cpu = _ADD_INT (aux, t->nice);
+  while (t->recent_cpu_epoch < mlfqs_seconds)
+  {
+    int second = ++t->recent_cpu_epoch;
+    int alpha;
+    if (mlfqs_seconds - second < DECAY_HISTORY)
+      alpha = decay_history[second % DECAY_HISTORY];
+    else
+      alpha = decay_history[(mlfqs_seconds + 1) % DECAY_HISTORY];
+    int aux = _MULTIPLY (alpha, t->recent_cpu);
+    t->recent_cpu = _ADD_INT (aux, t->nice);
+  }
 }
 
 /* Updates CPU load_avg using:
@@ -930,20 +1329,8 @@ thread_update_recent_cpu (struct thread *t)
 void
 thread_update_load_avg ()
 {
-  int thread_cnt = 0;
-  struct list_elem *e;
-  for (e = list_begin (&ready_list); e != list_end (&ready_list);
-       e = list_next (e))
-  {
-    struct thread *t = list_entry (e, struct thread, elem);
-    if (t != manager_thread && t != bsd_scheduler_thread && t != idle_thread)
-    {
-      thread_cnt++;
-    }
-  }
-
-  struct thread *t = thread_current ();
-  if (t != manager_thread && t != bsd_scheduler_thread && t != idle_thread)
+  int thread_cnt = ready_cnt;
+  if (thread_current () != idle_thread)
   {
     thread_cnt++;
   }
@@ -952,11 +1339,71 @@ thread_update_load_avg ()
   load_avg = _DIVIDE_INT (num, 60);
 }
 
+/* Once-per-second 4.4BSD update, run from the timer interrupt.
+   Updates load_avg, records this second's recent_cpu decay for
+   later use by thread_update_recent_cpu(), and brings the running
+   and ready threads up to date.  Ready threads must be handled
+   now because the decay can reorder them in the run queue;
+   blocked threads, however many, are left to catch up when they
+   are unblocked. */
+static void
+mlfqs_second (void)
+{
+  struct thread *cur = thread_current ();
+  struct list ready;
+  int pri;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  thread_update_load_avg ();
+  int double_load_avg = _MULTIPLY_INT (load_avg, 2);
+  mlfqs_seconds++;
+  decay_history[mlfqs_seconds % DECAY_HISTORY] =
+    _DIVIDE (double_load_avg, _ADD_INT (double_load_avg, 1));
+
+  if (cur != idle_thread)
+    thread_update_recent_cpu (cur);
+
+  /* Take every ready thread out of the run queue, highest
+     priority first, and put each back where it now belongs. */
+  list_init (&ready);
+  for (pri = PRI_MAX; pri >= PRI_MIN; pri--)
+    while (!list_empty (&ready_queues[pri]))
+    {
+      struct thread *t = list_entry (list_front (&ready_queues[pri]),
+                                     struct thread, elem);
+      ready_queue_remove (t);
+      list_push_back (&ready, &t->elem);
+    }
+  while (!list_empty (&ready))
+  {
+    struct thread *t = list_entry (list_pop_front (&ready),
+                                   struct thread, elem);
+    thread_update_recent_cpu (t);
+    t->priority = mlfqs_priority (t);
+    ready_queue_push (t, t->priority);
+  }
+}
+
 /* Sets the current thread's nice value to NICE. */
 void
 thread_set_nice (int nice UNUSED) 
 {
   struct thread *t = thread_current ();
+
+  /* The new weight applies from the next tick. */
+  if (thread_fair)
+  {
+    if (nice < NICE_MIN)
+      nice = NICE_MIN;
+    else if (nice > NICE_MAX)
+      nice = NICE_MAX;
+    t->nice = nice;
+    thread_yield ();
+    return;
+  }
+
+  thread_update_recent_cpu (t);
   t->nice = nice;
   thread_update_priority (t);
   /* If priority decreases due to nice value then yield it. */
@@ -981,62 +1428,161 @@ thread_get_load_avg (void)
 int
 thread_get_recent_cpu (void) 
 {
-  return _TO_INT_NEAREST (_MULTIPLY_INT (thread_current ()->recent_cpu, 100));
+  struct thread *t = thread_current ();
+  enum intr_level old_level = intr_disable ();
+  thread_update_recent_cpu (t);
+  intr_set_level (old_level);
+  return _TO_INT_NEAREST (_MULTIPLY_INT (t->recent_cpu, 100));
 }
-/*
-This type of scheduler maintains several queues of ready-to-run threads,
- where each queue holds threads with a different priority.
-At any given time, the scheduler chooses a thread from the highest-priority non-empty queue.
-If the highest-priority queue contains multiple threads,
- then they run in "round robin" order.
-*/
 
-void bsd_scheduler ()
+/* Returns true if T is in the real-time class and has budget
+   left, so that it is scheduled ahead of other threads. */
+static inline bool
+rt_runnable (struct thread *t)
 {
-  bsd_scheduler_thread = thread_current ();
+  return t->rt_period != 0 && !t->rt_throttled;
+}
+
+/* Returns true if real-time thread A's deadline is earlier than
+   B's. */
+static bool
+rt_deadline_less (const struct list_elem *a_, const struct list_elem *b_,
+                  void *aux UNUSED)
+{
+  const struct thread *a = list_entry (a_, struct thread, elem);
+  const struct thread *b = list_entry (b_, struct thread, elem);
+
+  return a->rt_deadline < b->rt_deadline;
+}
+
+/* Makes the current thread a real-time thread allowed BUDGET
+   ticks of CPU time in every PERIOD ticks, starting with a period
+   that begins now, or changes its parameters if it already is
+   one.  A PERIOD of 0 returns it to the ordinary scheduler.
+   Returns false, changing nothing, if BUDGET is out of range or
+   if admitting the thread would commit more than the whole
+   CPU. */
+bool
+thread_set_realtime (int64_t period, int64_t budget)
+{
+  struct thread *cur = thread_current ();
   enum intr_level old_level;
-  struct list_elem *elem;
+  int util;
 
-  while (true)
-  {
-    old_level = intr_disable ();
-    thread_block ();
-    intr_set_level (old_level);
-    old_level = intr_disable ();
-    /* Use MLFQS only if the flag is set at kernel boot. */
-    if(thread_mlfqs){
-      if (schedule_sec)
-      {
-        thread_update_load_avg ();
-        for (elem = list_begin (&all_list); elem != list_end (&all_list);
-             elem = list_next (elem))
-        {
-          struct thread *t = list_entry (elem, struct thread, allelem);
-          if (t != manager_thread && t != bsd_scheduler_thread && t != idle_thread)
-          {
-            thread_update_recent_cpu (t);
-          }
-        }
-        schedule_sec = false;
-      }
-      if (schedule_slice)
-      {
-        for (elem = list_begin (&all_list); elem != list_end (&all_list);
-             elem = list_next (elem))
+  if (period == 0)
+    {
+      rt_leave (cur);
+      thread_yield ();
+      return true;
+    }
+  if (period < 0 || budget <= 0 || budget > period)
+    return false;
+
+  /* Round up, so that rounding never admits an overload. */
+  util = DIV_ROUND_UP (budget * RT_UTIL_SCALE, period);
+
+  old_level = intr_disable ();
+  if (rt_utilization - cur->rt_util + util > RT_UTIL_SCALE)
+    {
+      intr_set_level (old_level);
+      return false;
+    }
+  if (cur->rt_period != 0)
+    timer_cancel (&cur->rt_timer);
+  rt_utilization += util - cur->rt_util;
+  cur->rt_util = util;
+  cur->rt_period = period;
+  cur->rt_budget = budget;
+  cur->rt_remaining = budget;
+  cur->rt_throttled = false;
+  cur->rt_deadline = timer_ticks () + period;
+  timer_add (&cur->rt_timer, cur->rt_deadline, rt_period_end, cur);
+  intr_set_level (old_level);
+  return true;
+}
+
+/* Ends the current real-time thread's job for this period: blocks
+   until the next period begins. */
+void
+thread_wait_next_period (void)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (cur->rt_period != 0);
+
+  old_level = intr_disable ();
+  cur->rt_waiting = true;
+  thread_block ();
+  intr_set_level (old_level);
+}
+
+/* Returns the number of deadlines the current thread has
+   missed. */
+int
+thread_get_rt_missed (void)
+{
+  return thread_current ()->rt_missed;
+}
+
+/* Timer function that ends real-time thread T_'s period and
+   starts the next: counts a miss unless T_ was waiting for it,
+   refills the budget, and moves the deadline one period on.  If
+   T_ is waiting in rt_ready_list, it is moved to its place for
+   the new deadline, to keep the list in deadline order. */
+static void
+rt_period_end (void *t_)
+{
+  struct thread *t = t_;
+  bool queued = t->status == THREAD_READY && !t->rt_throttled;
+
+  rt_periods++;
+  if (queued)
+    list_remove (&t->elem);
+  t->rt_deadline += t->rt_period;
+  if (queued)
+    list_insert_ordered (&rt_ready_list, &t->elem, rt_deadline_less, NULL);
+  t->rt_remaining = t->rt_budget;
+  timer_add (&t->rt_timer, t->rt_deadline, rt_period_end, t);
+
+  if (t->rt_waiting)
+    {
+      t->rt_waiting = false;
+      thread_unblock (t);
+    }
+  else
+    {
+      t->rt_missed++;
+      rt_missed++;
+      if (t->rt_throttled)
         {
-          struct thread *t = list_entry (elem, struct thread, allelem);
-          if (t != manager_thread && t != bsd_scheduler_thread && t != idle_thread)
-          {
-            thread_update_priority (t);
-          }
+          /* Ready, but in no run queue until now. */
+          t->rt_throttled = false;
+          ready_queue_push (t, ready_queue_priority (t));
         }
-        schedule_slice = false;
-      }
     }
-    intr_set_level (old_level);
-  }
+
+  if (t->status == THREAD_READY && thread_should_preempt (t))
+    intr_yield_on_return ();
 }
 
+/* Takes T out of the real-time class, if it is in it.  T must be
+   running. */
+static void
+rt_leave (struct thread *t)
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (t->rt_period != 0)
+    {
+      timer_cancel (&t->rt_timer);
+      rt_utilization -= t->rt_util;
+      t->rt_util = 0;
+      t->rt_period = 0;
+      t->rt_throttled = false;
+    }
+  intr_set_level (old_level);
+}
 
 /*********UP04**************/
 /* Extracting child thread from id */
@@ -3,8 +3,10 @@
 
 #include <debug.h>
 #include <list.h>
+#include <rusage.h>
 #include <stdint.h>
 #include "threads/synch.h"
+#include "devices/timer.h"
 #include "vm/page.h"
 
 /* States in a thread's life cycle. */
@@ -26,6 +28,14 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread nice values. */
+#define NICE_MIN -20                    /* Nicest. */
+#define NICE_MAX 20                     /* Least nice. */
+
+/* Longest chain of lock holders a priority donation is pushed
+   through. */
+#define DONATION_DEPTH_MAX 8
+
 /** UP03 **/
 #define MAX_FILES 128
 
@@ -94,11 +104,18 @@ struct thread
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
     int priority;                       /* Priority. */
+    int eff_priority;                   /* Priority including donations. */
     
     struct list_elem allelem;           /* List element for all threads list. */
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
+    int ready_pri;                      /* Run queue holding elem while ready. */
+    struct lock *waiting_lock;          /* Lock being waited on, if any. */
+    struct pqueue *wait_queue;          /* Semaphore waiters holding wait_elem. */
+    struct pqueue_elem wait_elem;       /* Semaphore waiters element. */
+    struct pqueue *cond_queue;          /* Condition waiters holding cond_elem. */
+    struct pqueue_elem *cond_elem;      /* Our condition waiters element. */
                                   
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
@@ -106,14 +123,36 @@ struct thread
 #endif
     /************ T02 **************/
     struct list locks_acquired ;        /* Locks accquired list */
-    bool no_yield;
+    struct rw_hold rw_holds[RW_HOLD_MAX]; /* rwlocks held for reading. */
     int old_priority;                   /* Old Priority. */
-    int64_t wakeup_at;                  /* Time to wait before unblock. */
-    struct list_elem sleepers_elem;     /* List element for sleepers_list. */
 
     /************ T03 **************/
     int nice;                           /* Nice Value. */
     int recent_cpu;                     /* Approximation of recent cpu time used by this thread. */
+    int recent_cpu_epoch;               /* Seconds of decay applied to recent_cpu. */
+
+    /* Fair-share scheduler. */
+    int64_t vruntime;                   /* Weighted run time, in FAIR_TICKs. */
+    struct thread *fair_left;           /* Children in the leftist heap */
+    struct thread *fair_right;          /*   of ready threads. */
+    int fair_rank;                      /* Length of shortest path to a leaf. */
+
+    /* Earliest-deadline-first real-time class.  rt_period is 0
+       for threads outside it. */
+    int64_t rt_period;                  /* Ticks between job releases. */
+    int64_t rt_budget;                  /* Ticks of CPU allowed per period. */
+    int rt_util;                        /* Utilization admitted, of RT_UTIL_SCALE. */
+    int64_t rt_deadline;                /* End of the current period. */
+    int64_t rt_remaining;               /* Budget left in this period. */
+    bool rt_throttled;                  /* Out of budget until the next period? */
+    bool rt_waiting;                    /* In thread_wait_next_period()? */
+    int rt_missed;                      /* Periods that ended with work left. */
+    struct timer rt_timer;              /* Fires at rt_deadline. */
+
+    /* Scheduling statistics. */
+    struct rusage usage;                /* Counters. */
+    int64_t state_since;                /* Tick of last status change. */
+    uint64_t unblocked_at;              /* Latency clock at unblock, or 0. */
 
     /** UP03 **/
     struct file *files[MAX_FILES];      /*files a thread can acquire */
@@ -146,11 +185,22 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the fair-share scheduler, which runs the ready
+   thread with the least CPU time used, weighted by nice.
+   Controlled by kernel command-line option "-fair". */
+extern bool thread_fair;
+
 void thread_init (void);
 void thread_start (void);
 
 void thread_tick (void);
 void thread_print_stats (void);
+void thread_print_usage (void);
+void thread_get_rusage (struct rusage *);
+void thread_reset_latency (void);
+unsigned thread_latency_count (int priority);
+uint64_t thread_clock (void);
+const char *thread_clock_unit (void);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
@@ -181,24 +231,27 @@ int thread_get_load_avg (void);
 
 
 /**************T01*******************/
-void thread_set_next_wakeup (void);
 void thread_priority_restore (void);
 
 
 /**************T02*******************/
 int thread_get_effective_priority(struct thread*);
-void thread_block_till (int64_t);
-bool priority_cmp (const struct list_elem*, const struct list_elem*, void*);
-bool before (const struct list_elem*, const struct list_elem*, void*);
 void thread_priority_temporarily_up (void);
+void thread_recompute_priority (struct thread *);
+void thread_donate_priority (struct thread *, int priority);
 
 /**************T03*******************/
-void manager_wakeup(void);
-void timer_wakeup(void);
 void thread_update_priority (struct thread *);
 void thread_update_recent_cpu (struct thread *);
 void thread_update_load_avg (void);
-bool priority_cmp_mlfqs (const struct list_elem*, const struct list_elem*, void*);
+void thread_requeue (struct thread *);
+bool thread_should_preempt (struct thread *);
+
+/* Earliest-deadline-first real-time class. */
+#define RT_UTIL_SCALE 10000             /* Utilization of a whole CPU. */
+bool thread_set_realtime (int64_t period, int64_t budget);
+void thread_wait_next_period (void);
+int thread_get_rt_missed (void);
 
 /*****UP04****/
 struct thread *get_child_thread_from_id (int);
@@ -84,8 +84,7 @@ start_process (void *file_name_)
         in the child process*/
     sema_up (&cur->sema_ready);
     enum intr_level old_level = intr_disable ();
-    cur->no_yield = true;
-    
+
     /*sema_terminated waits for wait() sycall to 
       get the proper exit status of the child process
       before exiting the child thread */
@@ -201,7 +201,6 @@ exit (void *esp)
   process_exit ();
 
   enum intr_level old_level = intr_disable ();
-  t->no_yield = true;
   sema_up (&t->sema_terminated);
   thread_block ();
   intr_set_level (old_level);
@@ -559,6 +558,22 @@ inumber (void *esp)
   exit (NULL);
 }
 
+/* Copies the calling thread's scheduling statistics into the
+   struct rusage it points to.  Returns 0. */
+static int
+getrusage (void *esp)
+{
+  validate (esp, esp, sizeof (struct rusage *));
+  struct rusage *usage = *((struct rusage **) esp);
+  esp += sizeof (struct rusage *);
+
+  validate (esp, usage, sizeof *usage);
+  is_writable (usage);
+  thread_get_rusage (usage);
+  unpin_buffer (usage, sizeof *usage);
+  return 0;
+}
+
 
 
 
@@ -587,7 +602,9 @@ static int (*syscalls []) (void *) =
     mkdir,
     readdir,
     isdir,
-    inumber
+    inumber,
+
+    getrusage
   };
 
 const int num_calls = sizeof (syscalls) / sizeof (syscalls[0]);
@@ -595,7 +612,7 @@ const int num_calls = sizeof (syscalls) / sizeof (syscalls[0]);
 void
 syscall_init (void) 
 {
-  lock_init (&file_lock);
+  lock_init_named (&file_lock, "file_lock");
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall"); 
 }
 
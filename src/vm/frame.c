@@ -6,8 +6,13 @@
 #include "vm/swap.h"
 #include "vm/frame.h"
 #include "vm/page.h"
-#include <malloc.h>
-#include "threads/malloc.h"
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+#include "userprog/process.h"
 
 ///*** VM01 ***///
 
@@ -17,32 +22,73 @@
 /* Function Declarations */
 static void *frame_alloc (enum palloc_flags);
 static void add_to_frame_table (void *, struct spt_entry *);
-static void clear_frame_entry (struct frame_table_entry *);
-bool evict_frame (struct frame_table_entry *);
-/* Frame table has been implemented in the form of Linked List */
-static struct list frame_table;
-
-/* Lock to edit frame table */ 
+static void finish_io (void);
+static struct frame_table_entry *frame_to_fte (void *);
+static bool write_back_frame (struct frame_table_entry *);
+static void cleaner_thread (void *);
+static void evict_frames (struct frame_table_entry *[], size_t);
+
+/* Frame table is an array with an entry for every page that palloc
+   may hand out as a user frame, indexed by page number from the
+   start of palloc's range (see palloc_get_range()), so that finding
+   the entry for a frame takes O(1) */
+static struct frame_table_entry *frames;
+static uint8_t *frames_base;
+static size_t frame_cnt;
+static size_t frames_used;
+
+/* Frames that are being loaded, evicted or cleaned, so cannot be
+   chosen as victims now but will be once their I/O is done */
+static size_t frames_busy;
+
+/* Index of the next entry the CLOCK hand looks at */
+static size_t clock_hand;
+
+/* Replacement statistics */
+static long long eviction_cnt;       // Frames evicted
+static long long dirty_eviction_cnt; // ... that had to be written out
+static long long scan_cnt;           // Frames in use looked at by the hand
+static long long accessed_skip_cnt;  // ... skipped because accessed
+static long long dirty_skip_cnt;     // ... skipped because dirty
+static long long io_wait_cnt;        // Waits for another thread's frame I/O
+
+/* Page cleaner.  Every FRAME_CLEAN_TICKS timer ticks, if free user
+   frames are below the high watermark, the cleaner writes back up to
+   FRAME_CLEAN_BATCH dirty MMAP pages, so that eviction finds them
+   clean and does not wait on the disk.  Either tunable set to 0 (by
+   the -clean-ticks and -clean-batch options) turns it off */
+int frame_clean_ticks = 10;
+int frame_clean_batch = 16;
+static long long background_clean_cnt;  // Pages written back by the cleaner
+static long long sync_clean_cnt;        // ... and by eviction
+
+/* Lock to edit frame table.  It protects each entry's state, page and
+   owner, and the frame field of pages in frames, but is never held
+   across disk I/O: a frame being loaded, evicted or cleaned is marked
+   so, and the lock is dropped until the I/O is done */
 static struct lock frame_table_lock;
 
-/*** Free frames finds the frame to be cleared in the frame table 
+/* Signalled, with frame_table_lock, whenever a frame stops being busy */
+static struct condition io_done;
+
+/*** Free frames removes the frame from the frame table and frees it
 ***/
 void free_frame (void *frame)
 {
-  struct frame_table_entry *fte;
-  struct list_elem *e;
+  struct frame_table_entry *fte = frame_to_fte (frame);
 
   lock_acquire (&frame_table_lock);
-  for (e = list_begin (&frame_table);
-       e != list_end (&frame_table);
-       e = list_next (e))
+  while (fte->cleaning)
+    cond_wait (&io_done, &frame_table_lock);
+  ASSERT (fte->state != FRAME_EVICTING);
+  if (fte->state != FRAME_FREE)
   {
-    fte = list_entry (e, struct frame_table_entry, elem);
-    if (fte->frame == frame)
-    {
-      list_remove (&fte->elem);
-      break;
-    }
+    if (fte->state == FRAME_LOADING)
+      finish_io ();
+    frames_used--;
+    fte->state = FRAME_FREE;
+    fte->spte = NULL;
+    fte->t = NULL;
   }
   lock_release (&frame_table_lock);
 
@@ -53,133 +99,230 @@ void free_frame (void *frame)
 /* Initialise frame Table*/
 void frame_table_init (void)
 {
-  list_init (&frame_table);
-  lock_init (&frame_table_lock);
+  void *base;
+  size_t i;
+
+  palloc_get_range (&base, &frame_cnt);
+  frames_base = base;
+  frames = palloc_get_multiple (PAL_ASSERT | PAL_ZERO,
+                                DIV_ROUND_UP (frame_cnt * sizeof *frames,
+                                              PGSIZE));
+  for (i = 0; i < frame_cnt; i++)
+  {
+    frames[i].frame = frames_base + i * PGSIZE;
+    frames[i].state = FRAME_FREE;
+  }
+
+  lock_init_named (&frame_table_lock, "frame_table_lock");
+  cond_init (&io_done);
+}
+
+/* Starts the page cleaner thread, unless it has been turned off */
+void frame_cleaner_start (void)
+{
+  if (frame_clean_ticks > 0 && frame_clean_batch > 0)
+    thread_create ("frame-cleaner", PRI_DEFAULT, cleaner_thread, NULL);
 }
 
-static struct frame_table_entry * get_victim_frame ()
+/* Returns the frame table entry for FRAME, the kernel address of
+   a user frame */
+static struct frame_table_entry *
+frame_to_fte (void *frame)
+{
+  size_t idx = pg_no (frame) - pg_no (frames_base);
+
+  ASSERT (pg_ofs (frame) == 0);
+  ASSERT (idx < frame_cnt);
+  return &frames[idx];
+}
+
+/* Notes that a busy frame's I/O is done and wakes up the threads
+   waiting for it */
+static void
+finish_io (void)
 {
   ASSERT (lock_held_by_current_thread (&frame_table_lock));
-  struct list_elem *e;
-  /***
-  Frames in Main Memory are classified on the basis of Access and Modification (Dirty bit)
-  00 --> neither recently used not modified – best page to replace
-  01 --> not recently used but modified – not quite as good, must write out before replacement
-  10 --> recently used but clean – probably will be used again soon
-  11 --> recently used and modified – probably will be used again soon and need to write out before replacement
-
-  ***/
-  /* Phase 1: All dirty frames are written back to disk
-              If 00 frame is found it is choosen as a victim */
-  for (e = list_begin (&frame_table);e != list_end (&frame_table);e = list_next (e))
-  {
-    struct frame_table_entry *fte =
-      list_entry (e, struct frame_table_entry, elem);
-    bool is_dirty = pagedir_is_dirty (fte->t->pagedir,fte->spte->upage);
-    bool is_accessed = pagedir_is_accessed (fte->t->pagedir,fte->spte->upage);
+  ASSERT (frames_busy > 0);
 
-    if (!fte->spte->pinned)
-    {
-      if (fte->spte->type != CODE)
-      {
-        if (is_dirty)
-        {
-          if (write_to_disk (fte->spte))
-            pagedir_set_dirty (fte->t->pagedir, fte->spte->upage, false);
-        }
-        else if (!is_accessed)
-          return fte;
-      }
-      else
-      {
-        if (!is_dirty && !is_accessed)
-          return fte;
-      }
-    }
-  }
+  frames_busy--;
+  cond_broadcast (&io_done, &frame_table_lock);
+}
 
-  /*** Phase 2: After previous phase all 01,11 --> 00,10
-                Now access bit is reset
-                If we find 00 then it is chosen as victim frame
-   ***/
-  for (e = list_begin (&frame_table);
-       e != list_end (&frame_table);
-       e = list_next (e))
+/*** Waits until SPTE's page is not being evicted.  Called before a page
+     is loaded or freed, because eviction unmaps the page before writing
+     it out and only updates SPTE once the write is done.  A fault on the
+     page meanwhile waits here and then reads the page back in.
+***/
+void frame_wait_page (struct spt_entry *spte)
+{
+  lock_acquire (&frame_table_lock);
+  while (spte->frame != NULL
+         && frame_to_fte (spte->frame)->state == FRAME_EVICTING)
   {
-    struct frame_table_entry *fte =
-      list_entry (e, struct frame_table_entry, elem);
-    bool is_dirty = pagedir_is_dirty (fte->t->pagedir,fte->spte->upage);
-    bool is_accessed = pagedir_is_accessed (fte->t->pagedir,fte->spte->upage);
-
-    if (!fte->spte->pinned)
-    {
-      if ((!is_dirty || fte->spte->type == CODE) && !is_accessed)
-        return fte;
-      else //Accessed or (Dirty (FILE or MMAP)).
-        pagedir_set_accessed (fte->t->pagedir, fte->spte->upage, false);
-    }
+    io_wait_cnt++;
+    cond_wait (&io_done, &frame_table_lock);
   }
+  lock_release (&frame_table_lock);
+}
+
+/* Marks FRAME, which was added to the frame table for a page being
+   loaded into it, as holding that page, now mapped, so that it can be
+   evicted */
+void frame_loaded (void *frame)
+{
+  struct frame_table_entry *fte = frame_to_fte (frame);
 
-  /***
-  Phase 3:
-  All frames in memory are now of the type 00 so
-  we find victim on the basis of FIFO 
-  ***/
-  ASSERT (!list_empty (&frame_table));
-  for (e = list_begin (&frame_table);e != list_end (&frame_table);e = list_next (e))
+  lock_acquire (&frame_table_lock);
+  ASSERT (fte->state == FRAME_LOADING);
+  fte->state = FRAME_IN_USE;
+  finish_io ();
+  lock_release (&frame_table_lock);
+}
+
+/*** Chooses a victim frame with the CLOCK algorithm.  The hand sweeps the
+     frame table in a circle, and stays where it stopped between evictions,
+     so every frame gets the same chance.  A frame whose page was accessed
+     since the hand last passed has its accessed bit cleared and is skipped.
+     A frame whose page is dirty is skipped once too, so that clean pages,
+     which cost no write, go first; it is taken the next time round if it
+     has not been accessed meanwhile.  Three sweeps give every frame both
+     chances, which bounds the scan.  Only frames in use whose pages are
+     mapped can be chosen.  Gives up after MAX_STEPS steps; only a scan
+     of more than three sweeps can fall back to taking any frame.
+***/
+static struct frame_table_entry * get_victim_frame (size_t max_steps)
+{
+  ASSERT (lock_held_by_current_thread (&frame_table_lock));
+  size_t steps;
+
+  for (steps = 0; steps < max_steps; steps++)
   {
-    struct frame_table_entry *fte = list_entry (e, struct frame_table_entry, elem);
-    if (!fte->spte->pinned){
+    struct frame_table_entry *fte = &frames[clock_hand];
+    clock_hand = (clock_hand + 1) % frame_cnt;
+
+    if (fte->state != FRAME_IN_USE || fte->spte->pinned || fte->cleaning)
+      continue;
+
+    /* Pages touched during the scan may keep their bits set, so after
+       three sweeps take whatever the hand finds */
+    if (steps >= 3 * frame_cnt)
       return fte;
+
+    scan_cnt++;
+    uint32_t *pd = fte->t->pagedir;
+    void *upage = fte->spte->upage;
+    if (pagedir_is_accessed (pd, upage))
+    {
+      pagedir_set_accessed (pd, upage, false);
+      fte->dirty_skipped = false;
+      accessed_skip_cnt++;
+    }
+    else if (pagedir_is_dirty (pd, upage) && !fte->dirty_skipped)
+    {
+      fte->dirty_skipped = true;
+      dirty_skip_cnt++;
     }
+    else
+      return fte;
   }
   return NULL;
 }
 
 
 
-bool evict_frame (struct frame_table_entry *fte)
+/* Returns true if evicting the page in FTE means writing it to swap */
+static bool
+goes_to_swap (struct frame_table_entry *fte)
+{
+  return fte->spte->type == CODE || fte->spte->type == FILE;
+}
+
+/* Claims FTE, chosen as a victim, for eviction by the current thread */
+static void
+claim_victim (struct frame_table_entry *fte)
+{
+  ASSERT (lock_held_by_current_thread (&frame_table_lock));
+  ASSERT (fte->spte->type < 3 && fte->spte->type >= 0);
+  ASSERT (fte->spte->frame == fte->frame);
+
+  fte->state = FRAME_EVICTING;
+  frames_busy++;
+}
+
+/*** Evicts the pages in the CNT frames in VICTIMS, which the caller has
+     claimed.  The pages are unmapped first, so that their owners fault on
+     them and wait in frame_wait_page() rather than changing them during
+     the writes.  The pages that go to swap are written out together, to
+     consecutive slots in one disk request if there is room.  The lock is
+     released for the writes and held again on return, when the frames
+     are free but still belong to the caller.
+***/
+static void evict_frames (struct frame_table_entry *victims[], size_t cnt)
 {
   ASSERT (lock_held_by_current_thread (&frame_table_lock));
-  struct spt_entry *spte = fte->spte;
-  size_t idx;
-  switch (spte->type){
-  case MMAP:
+  ASSERT (cnt > 0 && cnt <= SWAP_CLUSTER);
+  struct spt_entry *to_swap[SWAP_CLUSTER];
+  bool dirty[SWAP_CLUSTER];
+  size_t swap_cnt = 0;
+  size_t i;
 
-    if (pagedir_is_dirty (fte->t->pagedir, spte->upage))
-        if (!write_to_disk (spte))
-        {
-          PANIC ("Not able to write out");
-          return false;
-        }
+  for (i = 0; i < cnt; i++)
+  {
+    struct frame_table_entry *fte = victims[i];
+
+    ASSERT (fte->state == FRAME_EVICTING);
+    dirty[i] = pagedir_is_dirty (fte->t->pagedir, fte->spte->upage);
+    eviction_cnt++;
+    if (dirty[i])
+      dirty_eviction_cnt++;
+    pagedir_clear_page (fte->t->pagedir, fte->spte->upage);
+  }
+  lock_release (&frame_table_lock);
 
-    spte->frame = NULL;
-    
-    clear_frame_entry (fte);
-    return true;
-    break;
-  case FILE:
-    spte->type = CODE;
-  case CODE:
-    ASSERT (spte->frame != NULL);
-    idx = swap_out (spte);
-    if (idx == BITMAP_ERROR){
-      PANIC ("Not able to swap out");
-      return false;
+  for (i = 0; i < cnt; i++)
+  {
+    struct spt_entry *spte = victims[i]->spte;
+
+    switch (spte->type){
+    case MMAP:
+      if (dirty[i])
+      {
+        if (!write_back_frame (victims[i]))
+          PANIC ("Not able to write out");
+        sync_clean_cnt++;
+      }
+      break;
+    case FILE:
+      spte->type = CODE;
+    case CODE:
+      ASSERT (spte->frame != NULL);
+      to_swap[swap_cnt++] = spte;
+      break;
+    default:
+      PANIC ("Corrupt fte or spte");
     }
+  }
 
-    spte->idx = idx;
-    spte->is_in_swap = true;
-    spte->frame = NULL;
+  if (swap_cnt > 0)
+  {
+    if (!swap_out_cluster (to_swap, swap_cnt))
+      PANIC ("Not able to swap out");
+    for (i = 0; i < swap_cnt; i++)
+      to_swap[i]->is_in_swap = true;
+  }
 
-    clear_frame_entry (fte);
-    return true;
-    break;
-  default:
-    PANIC ("Corrupt fte or spte");
-    return false;
+  lock_acquire (&frame_table_lock);
+  for (i = 0; i < cnt; i++)
+  {
+    struct frame_table_entry *fte = victims[i];
+
+    fte->spte->frame = NULL;
+    frames_used--;
+    fte->state = FRAME_FREE;
+    fte->spte = NULL;
+    fte->t = NULL;
+    finish_io ();
   }
-  return true;
 }
 
 
@@ -210,6 +353,12 @@ void * get_frame_for_page (enum palloc_flags flags, struct spt_entry *spte)
 
 
 /*** Allocated a frame given the palloc flags (frame is also in essense stored on memeory hence we need a page for it as well)
+     When memory is full, claims a victim under the frame table lock and
+     evicts it without the lock, so that faults in other processes go on
+     meanwhile, then keeps the evicted frame for itself.  A victim bound
+     for swap brings up to SWAP_CLUSTER - 1 more such victims along, the
+     next ones the CLOCK hand finds within a sweep, so that they go out in
+     the same disk request; their frames are given back to palloc.
 ***/
 static void *
 frame_alloc (enum palloc_flags flags)
@@ -220,57 +369,185 @@ if (flags & PAL_USER == 0)
   void *frame = palloc_get_page (flags);
   if (frame != NULL)
     return frame;
-  else
-  {
-    lock_acquire (&frame_table_lock);
-    do {
-      if (list_empty (&frame_table))
-        PANIC ("palloc_get_page returned NULL when frame table empty.");
 
-      struct frame_table_entry *fte = get_victim_frame ();
+  lock_acquire (&frame_table_lock);
+  while ((frame = palloc_get_page (flags)) == NULL)
+  {
+    struct frame_table_entry *victims[SWAP_CLUSTER];
+    struct frame_table_entry *fte = get_victim_frame (4 * frame_cnt);
+    size_t cnt = 1;
+    size_t i;
 
-      ASSERT (fte != NULL);
-      
-      ASSERT (fte->spte->type < 3 && fte->spte->type >= 0 && fte->frame != NULL);
-      ASSERT (fte->spte->frame != NULL);
+    /* The only frames left may be busy with I/O */
+    if (fte == NULL && frames_busy > 0)
+    {
+      io_wait_cnt++;
+      cond_wait (&io_done, &frame_table_lock);
+      continue;
+    }
+    if (fte == NULL)
+      PANIC ("All frames are pinned.");
 
-      bool evicted = evict_frame (fte);
-      if (evicted){
-        frame = palloc_get_page (flags);
+    claim_victim (fte);
+    victims[0] = fte;
+    while (goes_to_swap (fte) && cnt < SWAP_CLUSTER)
+    {
+      struct frame_table_entry *next = get_victim_frame (frame_cnt);
+      if (next == NULL)
+        break;
+      if (!goes_to_swap (next))
+      {
+        /* Leave it to be the next victim */
+        clock_hand = next - frames;
+        break;
       }
-      else
-        PANIC ("Not able to evict. ");
-    } while (frame == NULL);
-      
-    lock_release (&frame_table_lock);
-    return frame;
+      claim_victim (next);
+      victims[cnt++] = next;
+    }
+
+    evict_frames (victims, cnt);
+    for (i = 0; i < cnt; i++)
+      palloc_note_eviction ();
+    for (i = 1; i < cnt; i++)
+      palloc_free_page (victims[i]->frame);
+    frame = fte->frame;
+    break;
   }
+  lock_release (&frame_table_lock);
+
+  /* palloc did not zero a frame taken from another page */
+  if (flags & PAL_ZERO)
+    memset (frame, 0, PGSIZE);
+  return frame;
 }
 
-/* Adds the newly allocated frame to the frame table */
+/* Adds the newly allocated frame to the frame table, as being loaded
+   until the caller calls frame_loaded() */
 static void add_to_frame_table (void *frame, struct spt_entry *spte)
 {
-  struct frame_table_entry *fte = (struct frame_table_entry *) malloc (sizeof (struct frame_table_entry));
+  struct frame_table_entry *fte = frame_to_fte (frame);
 
   lock_acquire (&frame_table_lock);
 
-  fte->frame = frame;
+  ASSERT (fte->state == FRAME_FREE);
+  fte->state = FRAME_LOADING;
+  frames_busy++;
   fte->spte = spte;
+  fte->dirty_skipped = false;
+  frames_used++;
   ASSERT (fte->spte->type < 3 && fte->spte->type >= 0);
   fte->t = thread_current ();
-  list_push_back (&frame_table, &fte->elem);
 
   lock_release (&frame_table_lock);
 }
 
+/* Writes the page in FTE, a MMAP page, back to its file.  It is
+   read through the frame's kernel address, because the caller need
+   not be the page's owner.  The dirty bit is cleared first, so that a
+   write to the page during the I/O makes it dirty again.  The frame
+   is marked as being evicted or cleaned, so that it cannot be freed
+   or reused meanwhile */
+static bool
+write_back_frame (struct frame_table_entry *fte)
+{
+  struct spt_entry *spte = fte->spte;
+  uint32_t *pd = fte->t->pagedir;
+
+  pagedir_set_dirty (pd, spte->upage, false);
+  lock_acquire (&file_lock);
+  off_t written = file_write_at (spte->file, fte->frame,
+                                 spte->page_read_bytes, spte->ofs);
+  lock_release (&file_lock);
+  if (written != (off_t) spte->page_read_bytes)
+  {
+    pagedir_set_dirty (pd, spte->upage, true);
+    return false;
+  }
+  return true;
+}
+
+/* Returns true if the cleaner should write back FTE: a dirty MMAP
+   page, mapped to the frame, that is not pinned and has not been
+   accessed since the CLOCK hand last passed, since a page in use
+   would only be dirtied again */
+static bool
+needs_cleaning (struct frame_table_entry *fte)
+{
+  ASSERT (lock_held_by_current_thread (&frame_table_lock));
+  struct spt_entry *spte = fte->spte;
 
+  return (fte->state == FRAME_IN_USE && spte->type == MMAP
+          && !spte->pinned && !fte->cleaning
+          && pagedir_get_page (fte->t->pagedir, spte->upage) == fte->frame
+          && !pagedir_is_accessed (fte->t->pagedir, spte->upage)
+          && pagedir_is_dirty (fte->t->pagedir, spte->upage));
+}
+
+/* Writes back up to FRAME_CLEAN_BATCH dirty pages, starting at the
+   CLOCK hand, where eviction will look next.  The frame table lock is
+   dropped during each write, so faults are not held up by the I/O */
 static void
-clear_frame_entry (struct frame_table_entry *fte)
+clean_batch (void)
 {
-  ASSERT (lock_held_by_current_thread (&frame_table_lock));
-  list_remove (&fte->elem);
+  size_t start, steps;
+  int cleaned = 0;
+
+  lock_acquire (&frame_table_lock);
+  start = clock_hand;
+  for (steps = 0; steps < frame_cnt && cleaned < frame_clean_batch; steps++)
+  {
+    struct frame_table_entry *fte = &frames[(start + steps) % frame_cnt];
+
+    if (!needs_cleaning (fte))
+      continue;
+
+    fte->cleaning = true;
+    frames_busy++;
+    lock_release (&frame_table_lock);
 
-  pagedir_clear_page (fte->t->pagedir, fte->spte->upage);
-  palloc_free_page (fte->frame);
-  free (fte);
+    if (write_back_frame (fte))
+    {
+      background_clean_cnt++;
+      cleaned++;
+    }
+
+    lock_acquire (&frame_table_lock);
+    fte->cleaning = false;
+    finish_io ();
+  }
+  lock_release (&frame_table_lock);
+}
+
+/* Page cleaner thread.  Cleans a batch whenever free user frames are
+   below one eighth of all user frames, and without waiting the full
+   interval while they are below one thirty-second */
+static void
+cleaner_thread (void *aux UNUSED)
+{
+  for (;;)
+  {
+    size_t free_cnt = palloc_free_cnt (PAL_USER);
+    size_t total = free_cnt + frames_used;
+
+    if (free_cnt < total / 32)
+      timer_sleep (1);
+    else
+      timer_sleep (frame_clean_ticks);
+
+    if (palloc_free_cnt (PAL_USER) < total / 8)
+      clean_batch ();
+  }
+}
+
+/* Prints page replacement statistics */
+void
+frame_print_stats (void)
+{
+  printf ("Frames: %lld evictions (%lld dirty), %lld frames scanned, "
+          "%lld skipped as accessed, %lld as dirty\n",
+          eviction_cnt, dirty_eviction_cnt, scan_cnt,
+          accessed_skip_cnt, dirty_skip_cnt);
+  printf ("Frames: %lld pages cleaned in background, "
+          "%lld during eviction, %lld waits for frame I/O\n",
+          background_clean_cnt, sync_clean_cnt, io_wait_cnt);
 }
@@ -7,21 +7,41 @@
 #include "vm/page.h"
 
 
-/*Structure for Frame table entry */
+/* State of a frame.  Only frames in use can be chosen for eviction; a
+   frame being loaded or evicted is waiting on disk I/O */
+enum frame_state
+{
+	FRAME_FREE,               // Not holding a page
+	FRAME_IN_USE,             // Holding a mapped page
+	FRAME_EVICTING,           // Page being written out
+	FRAME_LOADING             // Page being read in, not mapped yet
+};
+
+/*Structure for Frame table entry, one for each page that can be a user frame */
 
 struct frame_table_entry
 {
-	struct spt_entry *spte;
-	void *frame;
-	struct list_elem elem;
-	struct thread *t;
+	struct spt_entry *spte;   // Page in the frame, NULL if frame is free
+	void *frame;              // Kernel address of the frame
+	struct thread *t;         // Owner of the page
+	enum frame_state state;   // See above
+	bool dirty_skipped;       // Passed over by the CLOCK hand for being dirty
+	bool cleaning;            // Being written back by the page cleaner
 };
 
+/* Page cleaner tunables */
+extern int frame_clean_ticks;
+extern int frame_clean_batch;
+
 
 /* Global Function Declarations */
 void free_frame (void *);
 void frame_table_init (void);
+void frame_cleaner_start (void);
 void *get_frame_for_page (enum palloc_flags, struct spt_entry *);
+void frame_loaded (void *);
+void frame_wait_page (struct spt_entry *);
+void frame_print_stats (void);
 
 
 #endif
@@ -1,11 +1,13 @@
 #include "vm/page.h"
-#include <malloc.h>
 #include <bitmap.h>
 #include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/palloc.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
 #include "userprog/process.h"
 #include "filesys/file.h"
 
@@ -26,12 +28,21 @@ static bool install_load_swap (struct spt_entry *);
 /*** VM01 Creating Supp Page table (hash table) , adding , ddeleteing entries ***/
 /** SPTE Functions**/
 
+/* Cache of SPTEs, shared by all processes */
+static struct kmem_cache spte_cache;
+
+/* Initializes the SPTE cache */
+void page_init (void)
+{
+  kmem_cache_init (&spte_cache, "spt_entry", sizeof (struct spt_entry), NULL);
+}
+
 
 
 /* Creating new SPTE Entry */
 static struct spt_entry * create_spte ()
 {
-  struct spt_entry *spte = (struct spt_entry *) malloc ( sizeof (struct spt_entry));
+  struct spt_entry *spte = kmem_cache_alloc (&spte_cache);
   spte->frame = NULL;
   spte->upage = NULL;
   /*VM03 Checking if present in swap*/
@@ -55,6 +66,11 @@ static void free_spte (struct spt_entry *spte)
 {
   if (spte != NULL)
   {
+    /* Keeps the page from being evicted, and waits if it is being
+       evicted now, so that it is either in its frame or written out */
+    spte->pinned = true;
+    frame_wait_page (spte);
+
     /*If the Page has been allocated a frame remove it */
     if (spte->frame != NULL)
     {
@@ -70,7 +86,7 @@ static void free_spte (struct spt_entry *spte)
     }
     /* Removes entry from Supp page table*/
     hash_delete (&thread_current()->supp_page_table, &spte->elem);
-    free (spte);
+    kmem_cache_free (&spte_cache, spte);
   }
 }
 
@@ -126,13 +142,22 @@ struct spt_entry * uvaddr_to_spt_entry (void *uvaddr)
 /*Loads the page depending on the type of spte entry*/
 bool install_load_page (struct spt_entry *spte)
 {
+  bool success;
+
+  /* If the page is being evicted, it can only be read back once
+     it has been written out */
+  frame_wait_page (spte);
+
   switch (spte->type)
   {
-    case FILE:  return install_load_file (spte);
-    case MMAP:  return install_load_mmap (spte);
-    case CODE:  return install_load_swap (spte);
+    case FILE:  success = install_load_file (spte); break;
+    case MMAP:  success = install_load_mmap (spte); break;
+    case CODE:  success = install_load_swap (spte); break;
     default:    return false;
   }
+  if (success)
+    frame_loaded (spte->frame);
+  return success;
 }
 
 
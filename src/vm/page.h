@@ -37,6 +37,7 @@ struct spt_entry
 /* Global declaration of functions*/
 
 /* VM01 */
+void page_init (void);
 void supp_page_table_init (struct hash *);
 struct spt_entry *uvaddr_to_spt_entry (void *);
 bool create_spte_file (struct file *, off_t, uint8_t *, uint32_t, uint32_t, bool);
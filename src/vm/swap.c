@@ -1,79 +1,123 @@
+#include "vm/swap.h"
+#include <stdio.h>
 #include "threads/synch.h"
 #include "devices/disk.h"
 #include <bitmap.h>
 #include "vm/page.h"
-#include "userprog/process.h"
 
 static struct disk *swap_disk = NULL;
-/* Lock acquired whenever the swap table is accessed, no lock is required while 
-   using swap partition disk functions as it internally synchronizes accesses. */
+/* Lock acquired whenever the swap table is accessed.  It is not held
+   during I/O: the swap disk is not shared with the file system, and
+   the disk functions internally synchronize accesses, so a page is
+   read or written with just the slot it owns. */
 static struct lock swap_lock;
 static struct bitmap *swap_table = NULL;
 static uint32_t swap_table_size = 0;
 
+/* Swap statistics, updated under swap_lock */
+static long long pages_out_cnt;     // Pages written to swap
+static long long write_req_cnt;     // ... in this many disk requests
+static long long pages_in_cnt;      // Pages read back
+
 /* Initializes swap table bitmap. */
 void
-swap_init()
+swap_init (void)
 {
   swap_disk = disk_get (1,1);
-  lock_init (&swap_lock);
+  lock_init_named (&swap_lock, "swap_lock");
   if (swap_disk != NULL){
     swap_table_size = disk_size (swap_disk) / SECTORS_PER_PAGE;
     swap_table = bitmap_create (swap_table_size);
   }
 }
 
-/* Fetches an empty slot, for the given read-only memory frame, 
-   it puts it into swap partition and returns index which can help
-   swap_in the frame. */
-size_t
-swap_out (struct spt_entry *spte)
+/* Writes the CNT pages of SPTES, which must be in their frames, to CNT
+   consecutive swap slots with a single disk request.  Returns the
+   first slot, or BITMAP_ERROR if there is no run of CNT free slots. */
+static size_t
+write_slots (struct spt_entry *sptes[], size_t cnt)
 {
-  if (swap_table != NULL)
+  const void *sectors[SWAP_CLUSTER * SECTORS_PER_PAGE];
+  size_t idx, i, j;
+
+  ASSERT (cnt > 0 && cnt <= SWAP_CLUSTER);
+
+  lock_acquire (&swap_lock);
+  idx = bitmap_scan_and_flip (swap_table, 0, cnt, false);
+  lock_release (&swap_lock);
+  if (idx == BITMAP_ERROR)
+    return BITMAP_ERROR;
+
+  for (i = 0; i < cnt; i++)
+    for (j = 0; j < SECTORS_PER_PAGE; j++)
+      sectors[i * SECTORS_PER_PAGE + j] = (uint8_t *) sptes[i]->frame
+                                          + j * DISK_SECTOR_SIZE;
+  disk_write_multiple (swap_disk, idx * SECTORS_PER_PAGE, sectors,
+                       cnt * SECTORS_PER_PAGE);
+
+  lock_acquire (&swap_lock);
+  pages_out_cnt += cnt;
+  write_req_cnt++;
+  lock_release (&swap_lock);
+  return idx;
+}
+
+/* Writes the CNT pages of SPTES, which must be in their frames, out
+   to swap and sets each one's idx to its slot.  The pages go to
+   consecutive slots in one disk request if there are enough free
+   slots in a row, or else one at a time.  Returns false if swap is
+   full. */
+bool
+swap_out_cluster (struct spt_entry *sptes[], size_t cnt)
+{
+  size_t idx, i;
+
+  if (swap_table == NULL)
+    return false;
+
+  idx = write_slots (sptes, cnt);
+  if (idx != BITMAP_ERROR)
   {
-    lock_acquire (&swap_lock);
-    size_t idx = bitmap_scan_and_flip (swap_table, 0, 1, false);
-    if (idx != BITMAP_ERROR)
-    {
-      int i;
-      for (i = 0; i<SECTORS_PER_PAGE; i++)
-      {
-        lock_acquire (&file_lock);
-        disk_write (swap_disk, (idx * SECTORS_PER_PAGE) + i,
-                    spte->frame + (i * DISK_SECTOR_SIZE));
-        lock_release (&file_lock);
-      }
-    }
-    lock_release (&swap_lock);
-    return idx;
+    for (i = 0; i < cnt; i++)
+      sptes[i]->idx = idx + i;
+    return true;
   }
-  return BITMAP_ERROR;
+
+  for (i = 0; i < cnt; i++)
+  {
+    idx = write_slots (&sptes[i], 1);
+    if (idx == BITMAP_ERROR)
+      return false;
+    sptes[i]->idx = idx;
+  }
+  return true;
 }
 
-/* Gets a frame from allocator for the spte and loads the page from 
+/* Gets a frame from allocator for the spte and loads the page from
    SWAP partition to memory. */
 void
 swap_in (struct spt_entry *spte)
 {
   if (swap_table != NULL)
   {
-    lock_acquire (&swap_lock);
+    void *sectors[SECTORS_PER_PAGE];
     size_t idx = spte->idx;
     int i;
-    for (i = 0; i<SECTORS_PER_PAGE; i++)
-    {
-      lock_acquire (&file_lock);
-      disk_read (swap_disk, (idx * SECTORS_PER_PAGE) + i,
-                 spte->frame + (i * DISK_SECTOR_SIZE));
-      lock_release (&file_lock);
-    }
+
+    for (i = 0; i < SECTORS_PER_PAGE; i++)
+      sectors[i] = (uint8_t *) spte->frame + i * DISK_SECTOR_SIZE;
+    disk_read_multiple (swap_disk, idx * SECTORS_PER_PAGE, sectors,
+                        SECTORS_PER_PAGE);
+
+    lock_acquire (&swap_lock);
     bitmap_reset (swap_table, idx);
+    pages_in_cnt++;
     lock_release (&swap_lock);
   }
 }
 
 void
-swap_end ()
+swap_end (void)
 {
   if (swap_table != NULL)
   {
@@ -81,4 +125,12 @@ swap_end ()
     bitmap_destroy (swap_table);
     lock_release (&swap_lock);
   }
-}
\ No newline at end of file
+}
+
+/* Prints swap statistics */
+void
+swap_print_stats (void)
+{
+  printf ("Swap: %lld pages out in %lld requests, %lld pages in\n",
+          pages_out_cnt, write_req_cnt, pages_in_cnt);
+}
@@ -1,9 +1,18 @@
 #ifndef VM_SWAP
 #define VM_SWAP
 
-void swap_init();
-size_t swap_out (struct spt_entry *);
+#include <stdbool.h>
+#include <stddef.h>
+
+struct spt_entry;
+
+/* Most pages eviction writes out to swap in one disk request */
+#define SWAP_CLUSTER 8
+
+void swap_init (void);
+bool swap_out_cluster (struct spt_entry *[], size_t);
 void swap_in (struct spt_entry *);
-void swap_end ();
+void swap_end (void);
+void swap_print_stats (void);
 
-#endif
\ No newline at end of file
+#endif